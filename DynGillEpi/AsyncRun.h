@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __ASYNC_RUN_H__
+#define __ASYNC_RUN_H__
+
+#include <Utilities.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+using namespace std;
+
+//======================================================================
+// Simulation running on its own thread
+//======================================================================
+// The task is called as task(cancel) on a new thread, where cancel is an
+// atomic flag the simulation polls to stop early. Destroying a running
+// AsyncRun cancels it and waits for the thread to finish.
+template < typename RESULT >
+class AsyncRun {
+    public:
+        template < typename TASK >
+        explicit AsyncRun(TASK task) : finished(false), cancel_requested(false)
+        {
+            worker = thread([this, task]()
+            {
+                try
+                {
+                    RESULT r = task(cancel_requested);
+                    lock_guard < mutex > lock(state_mutex);
+                    result_value = move(r);
+                }
+                catch (...)
+                {
+                    lock_guard < mutex > lock(state_mutex);
+                    error = current_exception();
+                }
+                {
+                    lock_guard < mutex > lock(state_mutex);
+                    finished = true;
+                }
+                finished_condition.notify_all();
+            });
+        }
+
+        AsyncRun(const AsyncRun &) = delete;
+        AsyncRun & operator=(const AsyncRun &) = delete;
+
+        ~AsyncRun()
+        {
+            cancel();
+            if (worker.joinable())
+                worker.join();
+        }
+
+        bool done() const
+        {
+            lock_guard < mutex > lock(state_mutex);
+            return finished;
+        }
+
+        // Block until the run has finished or timeout seconds have passed
+        // (timeout < 0 waits indefinitely). Returns whether it finished.
+        bool wait(double timeout = -1.0) const
+        {
+            unique_lock < mutex > lock(state_mutex);
+            if (timeout < 0)
+            {
+                finished_condition.wait(lock, [this] { return finished; });
+                return true;
+            }
+            return finished_condition.wait_for(lock,
+                                               chrono::duration < double >(timeout),
+                                               [this] { return finished; });
+        }
+
+        // Result of the finished run. Rethrows the exception the run ended
+        // with, if any. Must only be called after the run has finished.
+        RESULT result() const
+        {
+            lock_guard < mutex > lock(state_mutex);
+            if (!finished)
+                throw logic_error("The simulation has not finished yet");
+            if (error)
+                rethrow_exception(error);
+            return result_value;
+        }
+
+        // Ask the run to stop. It ends with SimulationCancelled at the next
+        // point the simulation checks the flag.
+        void cancel() { cancel_requested = true; }
+        bool cancelled() const { return cancel_requested; }
+
+    private:
+        thread worker;
+        mutable mutex state_mutex;
+        mutable condition_variable finished_condition;
+        bool finished;
+        atomic < bool > cancel_requested;
+        RESULT result_value;
+        exception_ptr error;
+};
+
+#endif
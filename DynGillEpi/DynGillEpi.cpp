@@ -24,38 +24,865 @@
  */
 
 #include "Utilities.h"
+#include "TemporalNetwork.h"
+#include "NetworkFiles.h"
 #include "SIS_Poisson_homogeneous.h"
+#include "SIS_Poisson_heterogeneous.h"
+#include "SIR_Poisson_homogeneous.h"
+#include "SIR_Poisson_heterogeneous.h"
+#include "SIR_Poisson_homogeneous_contactRemoval.h"
+#include "SIR_nonMarkovian.h"
+#include "AsyncRun.h"
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <tuple>
+#include <utility>
 
 using namespace std;
 namespace py = pybind11;
 
-PYBIND11_PLUGIN(DynGillEpi) {
-    py::module m("DynGillEpi", "Module to perform fast flockwork simulations");
-    
-    m.def("SIS_Poisson_homogeneous", &SIS_Poisson_homogeneous, "Simulate an SIS process on a time-dependent contact list.",
+//======================================================================
+// Network construction from NumPy arrays (read through the buffer
+// protocol, no Python objects are touched per contact)
+//======================================================================
+template < typename INT >
+using CONTIGUOUS_ARRAY = py::array_t < INT, py::array::c_style >;
+
+typedef py::array_t < int64_t, py::array::c_style | py::array::forcecast > OFFSET_ARRAY;
+
+template < typename INT >
+TemporalNetwork network_from_edges(size_t N,
+                                   const CONTIGUOUS_ARRAY<INT> &edges,
+                                   const OFFSET_ARRAY &slice_offsets
+                                  )
+{
+    if (edges.ndim() != 2 || edges.shape(1) != 2)
+        throw invalid_argument("edges has to be of shape (number_of_contacts, 2)");
+    if (slice_offsets.ndim() != 1 || slice_offsets.shape(0) < 1)
+        throw invalid_argument("slice_offsets has to be of shape (number_of_slices+1,)");
+
+    return TemporalNetwork::from_edge_arrays(N,
+                                             edges.data(),
+                                             edges.shape(0),
+                                             slice_offsets.data(),
+                                             slice_offsets.shape(0)-1
+                                            );
+}
+
+template < typename INT >
+TemporalNetwork network_from_tij(size_t N,
+                                 const CONTIGUOUS_ARRAY<INT> &t,
+                                 const CONTIGUOUS_ARRAY<INT> &i,
+                                 const CONTIGUOUS_ARRAY<INT> &j,
+                                 size_t number_of_slices
+                                )
+{
+    if (t.ndim() != 1 || i.ndim() != 1 || j.ndim() != 1 || t.shape(0) != i.shape(0) || t.shape(0) != j.shape(0))
+        throw invalid_argument("t, i and j have to be one-dimensional arrays of equal length");
+
+    return TemporalNetwork::from_tij_arrays(N, t.data(), i.data(), j.data(), t.shape(0), number_of_slices);
+}
+
+//======================================================================
+// Results as NumPy arrays
+//======================================================================
+// The returned array is a view on the result's buffer. The capsule holds
+// a reference to the buffer, so the array stays valid independently of
+// the result object it came from.
+template < typename T >
+py::array_t<T> as_ndarray(const Array2D<T> &a)
+{
+    auto *owner = new shared_ptr < vector < T > >(a.buffer());
+    py::capsule base(owner, [](void *p) { delete reinterpret_cast < shared_ptr < vector < T > > * >(p); });
+    return py::array_t<T>({ a.rows(), a.cols() },
+                          { a.cols()*sizeof(T), sizeof(T) },
+                          (*owner)->data(),
+                          base
+                         );
+}
+
+// Copy of a column of a result
+template < typename T >
+py::array_t<T> as_ndarray(const vector<T> &v)
+{
+    return py::array_t<T>(v.size(), v.data());
+}
+
+// Read-only view on the storage of a shared array (e.g. a memory mapped
+// file), which the capsule keeps alive.
+template < typename T >
+py::array_t<T> as_ndarray(const SharedArray<T> &a)
+{
+    auto *owner = new shared_ptr < const void >(a.storage());
+    py::capsule base(owner, [](void *p) { delete reinterpret_cast < shared_ptr < const void > * >(p); });
+    py::array_t<T> array({ a.size() }, { sizeof(T) }, a.data(), base);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+// What the simulations hand to Python: the result classes as they are,
+// sweeps as a structured array with one record per point.
+template < typename RESULT >
+RESULT as_python(RESULT &&result)
+{
+    return move(result);
+}
+
+py::array_t<SweepPoint> as_python(vector < SweepPoint > &&points)
+{
+    return py::array_t<SweepPoint>(points.size(), points.data());
+}
+
+//======================================================================
+// Handles for simulations running in the background
+//======================================================================
+template < typename RESULT >
+void def_future(py::module &m, const char *name)
+{
+    py::class_< AsyncRun<RESULT> >(m, name,
+            "Handle of a simulation running on a background thread, as returned by the submit_* functions.")
+        .def("done", &AsyncRun<RESULT>::done, "Whether the simulation has finished (successfully or not).")
+        .def("poll", &AsyncRun<RESULT>::done, "Same as done().")
+        .def("wait",
+             [](const AsyncRun<RESULT> &run, py::object timeout)
+             {
+                 double seconds = timeout.is_none() ? -1.0 : timeout.cast<double>();
+                 py::gil_scoped_release release;
+                 return run.wait(seconds);
+             },
+             "Block until the simulation has finished or `timeout` seconds have passed. Returns whether it has finished.",
+             py::arg("timeout") = py::none()
+            )
+        .def("result",
+             [](const AsyncRun<RESULT> &run, py::object timeout)
+             {
+                 double seconds = timeout.is_none() ? -1.0 : timeout.cast<double>();
+                 bool finished;
+                 {
+                     py::gil_scoped_release release;
+                     finished = run.wait(seconds);
+                 }
+                 if (!finished)
+                 {
+                     PyErr_SetString(PyExc_TimeoutError, "The simulation did not finish within the timeout");
+                     throw py::error_already_set();
+                 }
+                 return as_python(run.result());
+             },
+             "Wait for the simulation and return its result. Raises the error the simulation ended with, "
+             "SimulationCancelled if it was cancelled, or TimeoutError if it did not finish within `timeout` seconds.",
+             py::arg("timeout") = py::none()
+            )
+        .def("cancel", &AsyncRun<RESULT>::cancel, "Ask the simulation to stop as soon as possible.")
+        .def("cancelled", &AsyncRun<RESULT>::cancelled, "Whether cancel() has been called.")
+        ;
+}
+
+//======================================================================
+// Simulation functions
+//======================================================================
+// For a library function run(network, parameters..., cancel) defines
+//     name(network, parameters...)
+//     name(N, list_of_contact_lists, parameters...)
+//     submit_name(network, parameters...)
+//     submit_name(N, list_of_contact_lists, parameters...)
+// The simulations release the GIL, the submit_ variants run in the
+// background and return an AsyncRun handle. I indexes the parameters
+// (all arguments of run but the network and cancel).
+template < typename RESULT, typename... ARGS, size_t... I, typename... EXTRA >
+void def_simulation_overloads(py::module &m,
+                              const string &name,
+                              const string &description,
+                              RESULT (*run)(const TemporalNetwork &, ARGS...),
+                              index_sequence < I... >,
+                              const EXTRA &... extra
+                             )
+{
+    typedef tuple < ARGS... > ARGUMENTS;
+    string submit_name = "submit_" + name;
+
+    m.def(name.c_str(),
+            [run](const TemporalNetwork &network, typename tuple_element < I, ARGUMENTS >::type... args)
+            {
+                RESULT result;
+                {
+                    // the simulation only touches C++ data, other Python threads can run meanwhile
+                    py::gil_scoped_release release;
+                    result = run(network, args..., nullptr);
+                }
+                return as_python(move(result));
+            },
+            ("Simulate " + description + " on a TemporalNetwork.").c_str(),
+            py::arg("network"),
+            extra...
+            );
+
+    m.def(name.c_str(),
+            [run](size_t N, const CONTACTS_LIST &list_of_contact_lists, typename tuple_element < I, ARGUMENTS >::type... args)
+            {
+                RESULT result;
+                {
+                    // the simulation only touches C++ data, other Python threads can run meanwhile
+                    py::gil_scoped_release release;
+                    TemporalNetwork network(N, list_of_contact_lists);
+                    result = run(network, args..., nullptr);
+                }
+                return as_python(move(result));
+            },
+            ("Simulate " + description + " on a time-dependent contact list.").c_str(),
+            py::arg("N"),
+            py::arg("list_of_contact_lists"),
+            extra...
+            );
+
+    m.def(submit_name.c_str(),
+            [run](shared_ptr<TemporalNetwork> network, typename tuple_element < I, ARGUMENTS >::type... args)
+            {
+                // the task keeps the network alive until it has finished
+                return unique_ptr< AsyncRun<RESULT> >(new AsyncRun<RESULT>(
+                    [=](const atomic < bool > &cancel)
+                    {
+                        return run(*network, args..., &cancel);
+                    }));
+            },
+            ("Start " + name + " on a TemporalNetwork in a background thread and return a handle to its result.").c_str(),
+            py::arg("network"),
+            extra...
+            );
+
+    m.def(submit_name.c_str(),
+            [run](size_t N, const CONTACTS_LIST &list_of_contact_lists, typename tuple_element < I, ARGUMENTS >::type... args)
+            {
+                shared_ptr<TemporalNetwork> network = make_shared<TemporalNetwork>(N, list_of_contact_lists);
+                return unique_ptr< AsyncRun<RESULT> >(new AsyncRun<RESULT>(
+                    [=](const atomic < bool > &cancel)
+                    {
+                        return run(*network, args..., &cancel);
+                    }));
+            },
+            ("Start " + name + " on a time-dependent contact list in a background thread and return a handle to its result.").c_str(),
             py::arg("N"),
             py::arg("list_of_contact_lists"),
-            py::arg("infection_rate_per_dt"),
-            py::arg("recovery_rate_per_dt"),
-            py::arg("T_simulation") = 0,
-            py::arg("output_time_resolution_in_dt") = 1,
-            py::arg("number_of_simulations") = 1,
-            py::arg("initial_number_of_infected") = 1,
-            py::arg("seed") = 0,
-            py::arg("t_infection_start") = 0,
-            py::arg("verbose") = false
+            extra...
             );
+}
+
+template < typename RESULT, typename... ARGS, typename... EXTRA >
+void def_simulation(py::module &m,
+                    const string &name,
+                    const string &description,
+                    RESULT (*run)(const TemporalNetwork &, ARGS...),
+                    const EXTRA &... extra
+                   )
+{
+    def_simulation_overloads(m, name, description, run, make_index_sequence < sizeof...(ARGS)-1 >(), extra...);
+}
+
+//======================================================================
+// Bindings
+//======================================================================
+#define SIMULATION_ARGS \
+            py::arg("T_simulation") = 0, \
+            py::arg("output_time_resolution_in_dt") = 1, \
+            py::arg("number_of_simulations") = 1, \
+            py::arg("initial_number_of_infected") = 1, \
+            py::arg("seed") = 0, \
+            py::arg("t_infection_start") = 0, \
+            py::arg("verbose") = false, \
+            py::arg("n_threads") = 1, \
+            py::arg("store_realizations") = true, \
+            py::arg("quantiles") = vector < double >(), \
+            py::arg("record_events") = false, \
+            py::arg("record_every") = 1, \
+            py::arg("record_min_interval") = 0.
+
+#define POISSON_ARGS \
+            py::arg("infection_rate_per_dt"), \
+            py::arg("recovery_rate_per_dt")
+
+#define HETEROGENEOUS_ARGS \
+            py::arg("susceptibilities"), \
+            py::arg("infectivities"), \
+            py::arg("recoverabilities")
+
+// 'sum_tree', 'composition_rejection' or 'cumulative', see with_sampler
+#define SAMPLER_ARG \
+            py::arg("sampler") = "sum_tree"
+
+#define SIS_POISSON_HOMOGENEOUS_ARGS POISSON_ARGS, SIMULATION_ARGS
+
+#define SWEEP_ARGS \
+            py::arg("infection_rates_per_dt"), \
+            py::arg("recovery_rates_per_dt"), \
+            py::arg("T_simulation") = 0, \
+            py::arg("number_of_simulations") = 1, \
+            py::arg("initial_numbers_of_infected") = vector < size_t >(1, 1), \
+            py::arg("seed") = 0, \
+            py::arg("t_infection_start") = 0, \
+            py::arg("verbose") = false, \
+            py::arg("n_threads") = 1
+
+template < typename INT >
+void def_array_overloads(py::module &m)
+{
+    m.def("SIS_Poisson_homogeneous",
+            [](size_t N,
+               const CONTIGUOUS_ARRAY<INT> &edges,
+               const OFFSET_ARRAY &slice_offsets,
+               double infection_rate_per_dt,
+               double recovery_rate_per_dt,
+               size_t T_simulation,
+               size_t output_time_resolution_in_dt,
+               size_t number_of_simulations,
+               size_t initial_number_of_infected,
+               size_t seed,
+               size_t t_infection_start,
+               bool verbose,
+               size_t n_threads,
+               bool store_realizations,
+               const vector < double > &quantiles,
+               bool record_events,
+               size_t record_every,
+               double record_min_interval
+              )
+            {
+                // the simulation only touches C++ data, other Python threads can run meanwhile
+                py::gil_scoped_release release;
+                TemporalNetwork network = network_from_edges<INT>(N, edges, slice_offsets);
+                return SIS_Poisson_homogeneous(network,
+                                               infection_rate_per_dt,
+                                               recovery_rate_per_dt,
+                                               T_simulation,
+                                               output_time_resolution_in_dt,
+                                               number_of_simulations,
+                                               initial_number_of_infected,
+                                               seed,
+                                               t_infection_start,
+                                               verbose,
+                                               n_threads,
+                                               store_realizations,
+                                               quantiles,
+                                               record_events,
+                                               record_every,
+                                               record_min_interval
+                                              );
+            },
+            "Simulate an SIS process on a temporal network given as a contiguous (number_of_contacts, 2) array `edges` "
+            "of int32 or int64 node pairs, where slice s holds the contacts edges[slice_offsets[s]:slice_offsets[s+1]].",
+            py::arg("N"),
+            py::arg("edges"),
+            py::arg("slice_offsets"),
+            SIS_POISSON_HOMOGENEOUS_ARGS
+            );
+
+    m.def("SIS_Poisson_homogeneous",
+            [](size_t N,
+               const CONTIGUOUS_ARRAY<INT> &t,
+               const CONTIGUOUS_ARRAY<INT> &i,
+               const CONTIGUOUS_ARRAY<INT> &j,
+               double infection_rate_per_dt,
+               double recovery_rate_per_dt,
+               size_t T_simulation,
+               size_t output_time_resolution_in_dt,
+               size_t number_of_simulations,
+               size_t initial_number_of_infected,
+               size_t seed,
+               size_t t_infection_start,
+               bool verbose,
+               size_t n_threads,
+               bool store_realizations,
+               const vector < double > &quantiles,
+               bool record_events,
+               size_t record_every,
+               double record_min_interval,
+               size_t number_of_slices
+              )
+            {
+                // the simulation only touches C++ data, other Python threads can run meanwhile
+                py::gil_scoped_release release;
+                TemporalNetwork network = network_from_tij<INT>(N, t, i, j, number_of_slices);
+                return SIS_Poisson_homogeneous(network,
+                                               infection_rate_per_dt,
+                                               recovery_rate_per_dt,
+                                               T_simulation,
+                                               output_time_resolution_in_dt,
+                                               number_of_simulations,
+                                               initial_number_of_infected,
+                                               seed,
+                                               t_infection_start,
+                                               verbose,
+                                               n_threads,
+                                               store_realizations,
+                                               quantiles,
+                                               record_events,
+                                               record_every,
+                                               record_min_interval
+                                              );
+            },
+            "Simulate an SIS process on a temporal network given as contiguous int32 or int64 arrays (t, i, j) "
+            "with one contact per entry and t in units of dt.",
+            py::arg("N"),
+            py::arg("t"),
+            py::arg("i"),
+            py::arg("j"),
+            SIS_POISSON_HOMOGENEOUS_ARGS,
+            py::arg("number_of_slices") = 0
+            );
+
+    // The network is built from the arrays before returning, so the
+    // background task does not depend on them.
+    m.def("submit_SIS_Poisson_homogeneous",
+            [](size_t N,
+               const CONTIGUOUS_ARRAY<INT> &edges,
+               const OFFSET_ARRAY &slice_offsets,
+               double infection_rate_per_dt,
+               double recovery_rate_per_dt,
+               size_t T_simulation,
+               size_t output_time_resolution_in_dt,
+               size_t number_of_simulations,
+               size_t initial_number_of_infected,
+               size_t seed,
+               size_t t_infection_start,
+               bool verbose,
+               size_t n_threads,
+               bool store_realizations,
+               const vector < double > &quantiles,
+               bool record_events,
+               size_t record_every,
+               double record_min_interval
+              )
+            {
+                shared_ptr<TemporalNetwork> network;
+                {
+                    py::gil_scoped_release release;
+                    network = make_shared<TemporalNetwork>(network_from_edges<INT>(N, edges, slice_offsets));
+                }
+                return unique_ptr< AsyncRun<SI_result> >(new AsyncRun<SI_result>(
+                    [=](const atomic < bool > &cancel)
+                    {
+                        return SIS_Poisson_homogeneous(*network,
+                                                       infection_rate_per_dt,
+                                                       recovery_rate_per_dt,
+                                                       T_simulation,
+                                                       output_time_resolution_in_dt,
+                                                       number_of_simulations,
+                                                       initial_number_of_infected,
+                                                       seed,
+                                                       t_infection_start,
+                                                       verbose,
+                                                       n_threads,
+                                                       store_realizations,
+                                                       quantiles,
+                                                       record_events,
+                                                       record_every,
+                                                       record_min_interval,
+                                                       &cancel
+                                                      );
+                    }));
+            },
+            "Start SIS_Poisson_homogeneous on (edges, slice_offsets) arrays in a background thread and return a handle to its result.",
+            py::arg("N"),
+            py::arg("edges"),
+            py::arg("slice_offsets"),
+            SIS_POISSON_HOMOGENEOUS_ARGS
+            );
+
+    m.def("submit_SIS_Poisson_homogeneous",
+            [](size_t N,
+               const CONTIGUOUS_ARRAY<INT> &t,
+               const CONTIGUOUS_ARRAY<INT> &i,
+               const CONTIGUOUS_ARRAY<INT> &j,
+               double infection_rate_per_dt,
+               double recovery_rate_per_dt,
+               size_t T_simulation,
+               size_t output_time_resolution_in_dt,
+               size_t number_of_simulations,
+               size_t initial_number_of_infected,
+               size_t seed,
+               size_t t_infection_start,
+               bool verbose,
+               size_t n_threads,
+               bool store_realizations,
+               const vector < double > &quantiles,
+               bool record_events,
+               size_t record_every,
+               double record_min_interval,
+               size_t number_of_slices
+              )
+            {
+                shared_ptr<TemporalNetwork> network;
+                {
+                    py::gil_scoped_release release;
+                    network = make_shared<TemporalNetwork>(network_from_tij<INT>(N, t, i, j, number_of_slices));
+                }
+                return unique_ptr< AsyncRun<SI_result> >(new AsyncRun<SI_result>(
+                    [=](const atomic < bool > &cancel)
+                    {
+                        return SIS_Poisson_homogeneous(*network,
+                                                       infection_rate_per_dt,
+                                                       recovery_rate_per_dt,
+                                                       T_simulation,
+                                                       output_time_resolution_in_dt,
+                                                       number_of_simulations,
+                                                       initial_number_of_infected,
+                                                       seed,
+                                                       t_infection_start,
+                                                       verbose,
+                                                       n_threads,
+                                                       store_realizations,
+                                                       quantiles,
+                                                       record_events,
+                                                       record_every,
+                                                       record_min_interval,
+                                                       &cancel
+                                                      );
+                    }));
+            },
+            "Start SIS_Poisson_homogeneous on (t, i, j) arrays in a background thread and return a handle to its result.",
+            py::arg("N"),
+            py::arg("t"),
+            py::arg("i"),
+            py::arg("j"),
+            SIS_POISSON_HOMOGENEOUS_ARGS,
+            py::arg("number_of_slices") = 0
+            );
+}
+
+PYBIND11_PLUGIN(DynGillEpi) {
+    py::module m("DynGillEpi", "Module to perform fast flockwork simulations");
+
+    py::register_exception<SimulationCancelled>(m, "SimulationCancelled");
+
+    py::class_<TemporalNetwork, shared_ptr<TemporalNetwork> >(m,"TemporalNetwork","Temporal network in compressed form, built once and reused by the simulations.")
+        .def(py::init<size_t, const CONTACTS_LIST &>(),
+             py::arg("N"),
+             py::arg("list_of_contact_lists")
+            )
+        .def(py::init(&network_from_edges<int32_t>), py::arg("N"), py::arg("edges"), py::arg("slice_offsets"))
+        .def(py::init(&network_from_edges<int64_t>), py::arg("N"), py::arg("edges"), py::arg("slice_offsets"))
+        .def(py::init(&network_from_tij<int32_t>), py::arg("N"), py::arg("t"), py::arg("i"), py::arg("j"), py::arg("number_of_slices") = 0)
+        .def(py::init(&network_from_tij<int64_t>), py::arg("N"), py::arg("t"), py::arg("i"), py::arg("j"), py::arg("number_of_slices") = 0)
+        .def(py::init([](const string &filename, size_t dt, size_t n_threads)
+                      {
+                          py::gil_scoped_release release;
+                          return open_network(filename, dt, n_threads).network;
+                      }),
+             "Open a network file like open_network, without the node labels.",
+             py::arg("filename"),
+             py::arg("dt") = 0,
+             py::arg("n_threads") = 0
+            )
+        .def_property_readonly("N", &TemporalNetwork::number_of_nodes)
+        .def_property_readonly("number_of_slices", &TemporalNetwork::number_of_slices)
+        .def_property_readonly("number_of_contacts", &TemporalNetwork::number_of_contacts)
+        .def("share",
+             [](const TemporalNetwork &network)
+             {
+                 py::gil_scoped_release release;
+                 return share_network(network);
+             },
+             "Copy of the network in a POSIX shared memory segment. It is pickled as the name of the segment, such that "
+             "multiprocessing workers map it instead of receiving a copy. The segment is removed once the last reference "
+             "to the copy in this process is gone, so keep it alive while workers start.")
+        .def_property_readonly("shared_memory_name",
+             [](const TemporalNetwork &network)
+             {
+                 string name = shared_memory_name(network);
+                 return name.empty() ? py::object(py::none()) : py::object(py::str(name));
+             },
+             "Name of the shared memory segment the network lives in, or None.")
+        .def_static("attach",
+             [](const string &name)
+             {
+                 py::gil_scoped_release release;
+                 return attach_network(name);
+             },
+             "Map the network that another process shared under the given name.",
+             py::arg("shared_memory_name"))
+        .def(py::pickle(
+             [](const TemporalNetwork &network)
+             {
+                 string name = shared_memory_name(network);
+                 if (!name.empty())
+                     return py::make_tuple("shared_memory", name);
+                 string bytes;
+                 {
+                     py::gil_scoped_release release;
+                     bytes = serialize_network(network);
+                 }
+                 return py::make_tuple("bytes", py::bytes(bytes));
+             },
+             [](py::tuple state)
+             {
+                 if (state.size() != 2)
+                     throw runtime_error("Invalid state of a pickled TemporalNetwork");
+                 string kind = state[0].cast<string>();
+                 string data = state[1].cast<string>();
+                 py::gil_scoped_release release;
+                 if (kind == "shared_memory")
+                     return attach_network(data);
+                 if (kind == "bytes")
+                     return deserialize_network(data);
+                 throw runtime_error("Invalid state of a pickled TemporalNetwork");
+             }))
+        ;
+
+    py::class_<NetworkFile>(m,"NetworkFile","Temporal network read from a file, as returned by open_network.")
+        .def_property_readonly("network", [](const NetworkFile &f) { return f.network; },
+                               "The TemporalNetwork (it shares the data of the file, nothing is copied).")
+        .def_property_readonly("node_ids", [](const NetworkFile &f) { return as_ndarray(f.node_ids); },
+                               "Label in the file of node n = 0,...,N-1, read-only uint64 array.")
+        .def_readonly("T_data", &NetworkFile::T_data, "Largest t in the data plus one.")
+        .def_readonly("dt", &NetworkFile::dt, "Slice s holds the contacts with s*dt <= t < (s+1)*dt.")
+        .def_readonly("load_time", &NetworkFile::load_time, "Wall time of loading in seconds.")
+        .def_property_readonly("megabytes_per_second", &NetworkFile::megabytes_per_second)
+        ;
+
+    m.def("open_network",
+            [](const string &filename, size_t dt, size_t n_threads)
+            {
+                py::gil_scoped_release release;
+                return open_network(filename, dt, n_threads);
+            },
+            "Open a binary network file (memory mapped, no parsing) or a text file with one contact 't i j' per line "
+            "(parsed on n_threads threads, 0 means all cores). The labels i, j are numbered 0,...,N-1 in increasing order "
+            "and slice s holds the contacts with s*dt <= t < (s+1)*dt. dt = 0 means 1 for text files and the dt a "
+            "binary file was converted with.",
+            py::arg("filename"),
+            py::arg("dt") = 0,
+            py::arg("n_threads") = 0
+            );
+
+    m.def("save_network",
+            [](const string &filename, const NetworkFile &file)
+            {
+                py::gil_scoped_release release;
+                save_network(filename, file);
+            },
+            "Write a network opened with open_network to a binary network file.",
+            py::arg("filename"),
+            py::arg("network_file")
+            );
+
+    m.def("convert_tij",
+            [](const string &tij_filename, const string &filename, size_t dt, size_t n_threads)
+            {
+                py::gil_scoped_release release;
+                save_network(filename, load_tij(tij_filename, dt, n_threads));
+            },
+            "Convert a text file with one contact 't i j' per line to a binary network file that open_network maps "
+            "without parsing.",
+            py::arg("tij_filename"),
+            py::arg("filename"),
+            py::arg("dt") = 1,
+            py::arg("n_threads") = 0
+            );
+
+    def_array_overloads<int32_t>(m);
+    def_array_overloads<int64_t>(m);
+
+    PYBIND11_NUMPY_DTYPE(SweepPoint,
+                         infection_rate_per_dt,
+                         recovery_rate_per_dt,
+                         initial_number_of_infected,
+                         number_of_simulations,
+                         number_stopped,
+                         mean_final_I,
+                         variance_final_I,
+                         mean_final_R,
+                         variance_final_R,
+                         mean_peak_I,
+                         variance_peak_I,
+                         simulation_time
+                        );
+
+    def_future<SI_result>(m, "SI_result_future");
+    def_future<SIR_result>(m, "SIR_result_future");
+    def_future< vector<SweepPoint> >(m, "sweep_future");
+
+    def_simulation(m, "SIS_Poisson_homogeneous", "an SIS process",
+                   &SIS_Poisson_homogeneous,
+                   SIS_POISSON_HOMOGENEOUS_ARGS
+                  );
+
+    def_simulation(m, "SIS_Poisson_heterogeneous",
+                   "a heterogeneous SIS process, where the infection rate of an SI contact is scaled by "
+                   "susceptibilities[S]*infectivities[I] and the recovery rate of a node by recoverabilities[I] "
+                   "(an empty list means 1 for every node)",
+                   &SIS_Poisson_heterogeneous,
+                   POISSON_ARGS,
+                   HETEROGENEOUS_ARGS,
+                   SIMULATION_ARGS,
+                   SAMPLER_ARG
+                  );
+
+    def_simulation(m, "SIR_Poisson_homogeneous", "an SIR process",
+                   &SIR_Poisson_homogeneous,
+                   POISSON_ARGS,
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIR_Poisson_heterogeneous",
+                   "a heterogeneous SIR process, where the infection rate of an SI contact is scaled by "
+                   "susceptibilities[S]*infectivities[I] and the recovery rate of a node by recoverabilities[I] "
+                   "(an empty list means 1 for every node)",
+                   &SIR_Poisson_heterogeneous,
+                   POISSON_ARGS,
+                   HETEROGENEOUS_ARGS,
+                   SIMULATION_ARGS,
+                   SAMPLER_ARG
+                  );
+
+    def_simulation(m, "SIR_Poisson_homogeneous_contactRemoval",
+                   "an SIR process, removing contacts that can not transmit anymore for the rest of a realization",
+                   &SIR_Poisson_homogeneous_contactRemoval,
+                   POISSON_ARGS,
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIR_nonMarkovian",
+                   "an SIR process with Weibull distributed recovery times of inverse scale recovery_rate_per_dt "
+                   "and the given shape, keeping the recovery rate of a node within a factor 1+precision of the exact hazard",
+                   &SIR_nonMarkovian,
+                   POISSON_ARGS,
+                   py::arg("shape"),
+                   py::arg("precision"),
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIR_nonMarkovian_gamma",
+                   "an SIR process with gamma distributed recovery times of the given shape and scale (in time steps), "
+                   "keeping the recovery rate of a node within a factor 1+precision of the exact hazard",
+                   &SIR_nonMarkovian_gamma,
+                   py::arg("infection_rate_per_dt"),
+                   py::arg("shape"),
+                   py::arg("scale"),
+                   py::arg("precision"),
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIR_nonMarkovian_lognormal",
+                   "an SIR process with log-normally distributed recovery times of the given median (in time steps) "
+                   "and standard deviation sigma of the logarithm, keeping the recovery rate of a node within a factor "
+                   "1+precision of the exact hazard",
+                   &SIR_nonMarkovian_lognormal,
+                   py::arg("infection_rate_per_dt"),
+                   py::arg("median"),
+                   py::arg("sigma"),
+                   py::arg("precision"),
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIR_nonMarkovian_empirical",
+                   "an SIR process with recovery times distributed as in a histogram of observed infectious periods, "
+                   "histogram[j] counting the periods in [j*bin_width, (j+1)*bin_width) time steps",
+                   &SIR_nonMarkovian_empirical,
+                   py::arg("infection_rate_per_dt"),
+                   py::arg("histogram"),
+                   py::arg("bin_width"),
+                   SIMULATION_ARGS
+                  );
+
+    def_simulation(m, "SIS_Poisson_homogeneous_sweep",
+                   "an SIS process at every point (infection_rates_per_dt[p], recovery_rates_per_dt[p]) of a "
+                   "parameter grid (a list of length 1 is used for all points), with all realizations of all points "
+                   "shared out over n_threads threads. Returns a structured array with one record per point: the "
+                   "rates, number_of_simulations, number_stopped and mean and variance of final_I, final_R and "
+                   "peak_I. Realization q draws from the same random stream at every point, as in separate calls "
+                   "with the same seed",
+                   &SIS_Poisson_homogeneous_sweep,
+                   SWEEP_ARGS
+                  );
+
+    def_simulation(m, "SIR_Poisson_homogeneous_sweep",
+                   "an SIR process at every point of a parameter grid, like SIS_Poisson_homogeneous_sweep",
+                   &SIR_Poisson_homogeneous_sweep,
+                   SWEEP_ARGS
+                  );
+
+    py::class_<FrameStatistics>(m,"FrameStatistics","Statistics of an observable over all realizations, per recorded time.")
+        .def_property_readonly("mean", [](const FrameStatistics &f) { return as_ndarray(f.mean); })
+        .def_property_readonly("variance", [](const FrameStatistics &f) { return as_ndarray(f.variance); },
+                               "Unbiased sample variance.")
+        .def_property_readonly("quantiles", [](const FrameStatistics &f) { return as_ndarray(f.quantiles); },
+                               "Estimates of the quantiles asked for, array of shape (len(quantiles), number of recorded times), "
+                               "within a relative error of 1%.")
+        ;
+
+    py::class_<EventRecord>(m,"EventRecord",
+            "(t, I, SI) at the start of every slice and after every event, as far as recorded (see record_every and "
+            "record_min_interval). Realization q holds the entries offsets[q]:offsets[q+1] of the columns.")
+        .def_property_readonly("t", [](const EventRecord &e) { return as_ndarray(e.t); }, "Time in units of dt, float32.")
+        .def_property_readonly("I", [](const EventRecord &e) { return as_ndarray(e.I); }, "Number of infected, uint32.")
+        .def_property_readonly("SI", [](const EventRecord &e) { return as_ndarray(e.SI); }, "Number of SI contacts, uint32.")
+        .def_property_readonly("offsets", [](const EventRecord &e) { return as_ndarray(e.offsets); })
+        .def("realization",
+             [](const EventRecord &e, size_t q)
+             {
+                 if (q+1 >= e.offsets.size())
+                     throw out_of_range("No events were recorded for realization " + to_string(q));
+                 size_t first = e.offsets[q], length = e.offsets[q+1] - first;
+                 return py::make_tuple(py::array_t<float>(length, e.t.data() + first),
+                                       py::array_t<uint32_t>(length, e.I.data() + first),
+                                       py::array_t<uint32_t>(length, e.SI.data() + first)
+                                      );
+             },
+             "The columns (t, I, SI) of realization q.",
+             py::arg("q")
+            )
+        ;
+
+    py::class_<ThreadUtilization>(m,"ThreadUtilization","How the realizations were spread over the threads.")
+        .def_property_readonly("tasks", [](const ThreadUtilization &u) { return as_ndarray(u.tasks); },
+                               "Number of realizations per thread.")
+        .def_property_readonly("busy_time", [](const ThreadUtilization &u) { return as_ndarray(u.busy_time); },
+                               "Seconds each thread spent simulating.")
+        .def_readonly("wall_time", &ThreadUtilization::wall_time, "Wall time of the ensemble in seconds.")
+        .def_property_readonly("utilization",
+                               [](const ThreadUtilization &u)
+                               {
+                                   vector < double > busy(u.tasks.size());
+                                   for(size_t thread = 0; thread < busy.size(); ++thread)
+                                       busy[thread] = u.utilization(thread);
+                                   return as_ndarray(busy);
+                               },
+                               "Fraction of the wall time each thread was busy.")
+        ;
 
     py::class_<SI_result>(m,"SI_result")
         .def(py::init<>())
-        .def_readwrite("true_I", &SI_result::true_I)
-        .def_readwrite("true_SI", &SI_result::true_SI)
-        .def_readwrite("true_t", &SI_result::true_t)
-        .def_readwrite("I", &SI_result::I)
-        .def_readwrite("SI", &SI_result::SI)
+        .def_readonly("events", &SI_result::events, "Events, if record_events was True.")
+        .def_property_readonly("I", [](const SI_result &r) { return as_ndarray(r.I); },
+                               "Number of infected at each recorded time, array of shape (number_of_simulations, T_simulation/output_time_resolution_in_dt) "
+                               "(no rows if store_realizations was False).")
+        .def_property_readonly("SI", [](const SI_result &r) { return as_ndarray(r.SI); },
+                               "Number of SI contacts at each recorded time, array of same shape as I.")
         .def_readwrite("hist", &SI_result::hist)
+        .def_readonly("I_statistics", &SI_result::I_statistics)
+        .def_readonly("SI_statistics", &SI_result::SI_statistics)
+        .def_readwrite("final_size_histogram", &SI_result::final_size_histogram,
+                       "Number of realizations that end with k infected, k = 0,...,N.")
+        .def_readonly("threads", &SI_result::threads)
+        ;
+
+    py::class_<SIR_result>(m,"SIR_result")
+        .def(py::init<>())
+        .def_readonly("events", &SIR_result::events, "Events, if record_events was True.")
+        .def_property_readonly("I", [](const SIR_result &r) { return as_ndarray(r.I); },
+                               "Number of infected at each recorded time, array of shape (number_of_simulations, T_simulation/output_time_resolution_in_dt) "
+                               "(no rows if store_realizations was False).")
+        .def_property_readonly("SI", [](const SIR_result &r) { return as_ndarray(r.SI); },
+                               "Number of SI contacts at each recorded time, array of same shape as I.")
+        .def_property_readonly("R", [](const SIR_result &r) { return as_ndarray(r.R); },
+                               "Number of recovered at each recorded time, array of same shape as I.")
+        .def_readwrite("hist", &SIR_result::hist, "Number of recovered at the end of each realization.")
+        .def_readonly("I_statistics", &SIR_result::I_statistics)
+        .def_readonly("SI_statistics", &SIR_result::SI_statistics)
+        .def_readonly("R_statistics", &SIR_result::R_statistics)
+        .def_readwrite("final_size_histogram", &SIR_result::final_size_histogram,
+                       "Number of realizations that end with k recovered, k = 0,...,N.")
+        .def_readonly("threads", &SIR_result::threads)
         ;
 
     return m.ptr();
@@ -0,0 +1,203 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __ENSEMBLE_STATISTICS_H__
+#define __ENSEMBLE_STATISTICS_H__
+
+#include <Utilities.h>
+#include <cstdint>
+
+using namespace std;
+
+//======================================================================
+// Statistics over the realizations of an ensemble, per frame
+//======================================================================
+// The accumulators below take one realization at a time as an array with
+// one value per frame, so their memory does not depend on the number of
+// realizations. The observables are counts (of nodes or contacts) below
+// 2^32. Both accumulators only hold integers, so merging those of several
+// threads gives the same result in any order.
+
+//----------------------------------------------------------------------
+// Mean and variance from exact sums of the values and their squares
+//----------------------------------------------------------------------
+class FrameMoments {
+    public:
+        void reset(size_t frames)
+        {
+            n = 0;
+            sum.assign(frames,0);
+            square_low.assign(frames,0);
+            square_high.assign(frames,0);
+        }
+
+        void add(const size_t *x)
+        {
+            ++n;
+            for(size_t k = 0; k < sum.size(); ++k)
+            {
+                uint64_t square = (uint64_t) x[k] * x[k];
+                sum[k] += x[k];
+                square_low[k] += square;
+                square_high[k] += square_low[k] < square; // carry
+            }
+        }
+
+        void merge(const FrameMoments &other)
+        {
+            n += other.n;
+            for(size_t k = 0; k < sum.size(); ++k)
+            {
+                sum[k] += other.sum[k];
+                square_low[k] += other.square_low[k];
+                square_high[k] += other.square_high[k] + (square_low[k] < other.square_low[k]);
+            }
+        }
+
+        size_t count() const { return n; }
+
+        vector < double > mean() const
+        {
+            vector < double > m(sum.size(), 0.);
+            for(size_t k = 0; k < sum.size() && n > 0; ++k)
+                m[k] = (double) sum[k] / n;
+            return m;
+        }
+
+        // unbiased sample variance, 0 for fewer than two realizations
+        vector < double > variance() const
+        {
+            vector < double > v(sum.size(), 0.);
+            for(size_t k = 0; k < sum.size() && n > 1; ++k)
+            {
+                long double squares = ldexpl((long double) square_high[k], 64) + square_low[k];
+                long double s = sum[k];
+                v[k] = (double) max((squares - s*s/n) / (n-1), (long double) 0);
+            }
+            return v;
+        }
+
+    private:
+        size_t n = 0; // number of realizations
+        vector < uint64_t > sum;
+        vector < uint64_t > square_low; // sum of squares = 2^64*square_high + square_low
+        vector < uint64_t > square_high;
+};
+
+//----------------------------------------------------------------------
+// Quantiles from logarithmic histograms (as in DDSketch)
+//----------------------------------------------------------------------
+// The values v > 0 are counted in buckets (g^(b-1), g^b] with
+// g = (1+accuracy)/(1-accuracy), such that every bucket has a
+// representative within a relative error of accuracy of all its values.
+// Buckets that only hold a single integer (all v < about 1/accuracy) are
+// exact. The counts are shared by all threads and updated atomically, so
+// an ensemble needs one sketch per observable, not per thread.
+class FrameQuantileSketch {
+    public:
+        FrameQuantileSketch() = default;
+        FrameQuantileSketch(const FrameQuantileSketch &) = delete;
+        FrameQuantileSketch & operator=(const FrameQuantileSketch &) = delete;
+
+        // for values 0,...,max_value (larger ones count as max_value)
+        void reset(size_t frames, size_t max_value, double accuracy)
+        {
+            if (!(accuracy > 0 && accuracy < 1))
+                throw invalid_argument("The accuracy of the quantiles has to be in (0,1)");
+            double gamma = (1+accuracy) / (1-accuracy);
+
+            // number the non-empty buckets of the values 0,...,max_value
+            bucket_of.assign(max_value+1, 0);
+            representative.assign(1, 0.);
+            long long last = 0;
+            for(size_t v = 1; v <= max_value; ++v)
+            {
+                long long b = (long long) ceil(log((double) v) / log(gamma));
+                if (v == 1 || b != last)
+                    representative.push_back(2 * pow(gamma, (double) b) / (gamma+1));
+                last = b;
+                bucket_of[v] = representative.size()-1;
+            }
+            // buckets of one integer are exact, the others within [lowest, highest]
+            vector < size_t > lowest(representative.size(), max_value+1), highest(representative.size(), 0);
+            for(size_t v = 0; v <= max_value; ++v)
+            {
+                lowest[bucket_of[v]] = min(lowest[bucket_of[v]], v);
+                highest[bucket_of[v]] = max(highest[bucket_of[v]], v);
+            }
+            for(size_t b = 0; b < representative.size(); ++b)
+                representative[b] = min(max(representative[b], (double) lowest[b]), (double) highest[b]);
+
+            number_of_frames = frames;
+            number_of_buckets = representative.size();
+            counts.reset(new atomic < size_t >[frames * number_of_buckets]());
+            n = 0;
+        }
+
+        // may be called from several threads at once
+        void add(const size_t *x)
+        {
+            size_t max_value = bucket_of.size()-1;
+            atomic < size_t > *frame = counts.get();
+            for(size_t k = 0; k < number_of_frames; ++k, frame += number_of_buckets)
+                frame[bucket_of[min(x[k], max_value)]].fetch_add(1, memory_order_relaxed);
+            n.fetch_add(1, memory_order_relaxed);
+        }
+
+        // estimate of quantile q[m] in frame k at (m,k)
+        Array2D < double > quantiles(const vector < double > &q) const
+        {
+            for(auto const &quantile: q)
+                if (!(quantile >= 0 && quantile <= 1))
+                    throw invalid_argument("Quantiles have to be in [0,1]");
+
+            Array2D < double > result(q.size(), number_of_frames);
+            size_t total = n.load();
+            if (total == 0)
+                return result;
+
+            const atomic < size_t > *frame = counts.get();
+            for(size_t k = 0; k < number_of_frames; ++k, frame += number_of_buckets)
+                for(size_t m = 0; m < q.size(); ++m)
+                {
+                    // first bucket that holds more than rank values
+                    double rank = q[m] * (total-1);
+                    size_t b = 0, cumulative = frame[0].load(memory_order_relaxed);
+                    while (cumulative <= rank && b+1 < number_of_buckets)
+                        cumulative += frame[++b].load(memory_order_relaxed);
+                    result(m,k) = representative[b];
+                }
+            return result;
+        }
+
+    private:
+        vector < COUNTER > bucket_of; // bucket of every value
+        vector < double > representative; // estimate of the values in every bucket
+        size_t number_of_frames = 0;
+        size_t number_of_buckets = 0;
+        unique_ptr < atomic < size_t >[] > counts; // frames x buckets
+        atomic < size_t > n{0};
+};
+
+#endif
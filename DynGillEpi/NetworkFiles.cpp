@@ -0,0 +1,989 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "NetworkFiles.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+//======================================================================
+// Memory map
+//======================================================================
+MappedFile::MappedFile(const string &filename) : first(nullptr), length(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("File " + filename + " cannot be read");
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        throw runtime_error("File " + filename + " cannot be read");
+    }
+    length = status.st_size;
+
+    // an empty file can not be mapped, it is represented by a null pointer
+    if (length > 0)
+    {
+        void * address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("File " + filename + " cannot be mapped to memory");
+        }
+        madvise(address, length, MADV_SEQUENTIAL);
+        first = (const char *) address;
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (first)
+        munmap((void *) first, length);
+}
+
+//======================================================================
+// tij text files
+//======================================================================
+namespace {
+
+    // Hash map from labels to node numbers 0,1,... in the order the labels
+    // are first seen (open addressing with linear probing, which is a lot
+    // faster than unordered_map for the many lookups of repeated labels)
+    class LabelIndex {
+        public:
+            LabelIndex() : mask(1023), slots(1024, make_pair(0,NO_NODE)) {}
+
+            NODE node(NODE_ID label)
+            {
+                size_t h = hash(label);
+                while (slots[h].second != NO_NODE)
+                {
+                    if (slots[h].first == label)
+                        return slots[h].second;
+                    h = (h+1) & mask;
+                }
+                slots[h] = make_pair(label, (NODE) labels.size());
+                labels.push_back(label);
+                if (2*labels.size() > mask)
+                    grow();
+                return labels.size()-1;
+            }
+
+            // NO_NODE if the label has not been seen
+            NODE find(NODE_ID label) const
+            {
+                size_t h = hash(label);
+                while (slots[h].second != NO_NODE && slots[h].first != label)
+                    h = (h+1) & mask;
+                return slots[h].second;
+            }
+
+            static const NODE NO_NODE = (NODE) -1;
+            vector < NODE_ID > labels; // labels[n] is the label of node n
+
+        private:
+            // mixes all bits of the label into the low ones (MurmurHash3 finalizer)
+            size_t hash(NODE_ID label) const
+            {
+                label = (label ^ (label >> 33)) * 0xff51afd7ed558ccdULL;
+                label = (label ^ (label >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+                return (size_t) (label ^ (label >> 33)) & mask;
+            }
+
+            void grow()
+            {
+                mask = 2*mask+1;
+                slots.assign(mask+1, make_pair(0,NO_NODE));
+                for(size_t n = 0; n < labels.size(); ++n)
+                {
+                    size_t h = hash(labels[n]);
+                    while (slots[h].second != NO_NODE)
+                        h = (h+1) & mask;
+                    slots[h] = make_pair(labels[n], (NODE) n);
+                }
+            }
+
+            size_t mask;
+            vector < pair < NODE_ID, NODE > > slots;
+    };
+
+    const NODE LabelIndex::NO_NODE;
+
+    // Contacts of one chunk of the file, with the nodes numbered in the
+    // order they appear in the chunk
+    struct TijChunk {
+        NODES slices;
+        NODES i;
+        NODES j;
+        NODE_ID t_max = 0;
+        LabelIndex index;
+    };
+
+    inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    // Reads the blank separated integer at p and moves p behind it.
+    // Returns false if there is no integer at p or it is >= 2^64.
+    inline bool parse_integer(const char * &p, const char *end, NODE_ID &value)
+    {
+        while (p < end && is_blank(*p))
+            ++p;
+        if (p == end || !is_digit(*p))
+            return false;
+
+        const NODE_ID max_value = numeric_limits < NODE_ID >::max();
+        value = 0;
+        while (p < end && is_digit(*p))
+        {
+            NODE_ID digit = *p - '0';
+            if (value > (max_value - digit) / 10)
+                return false;
+            value = 10*value + digit;
+            ++p;
+        }
+        return p == end || is_blank(*p) || *p == '\n';
+    }
+
+    // Calls f(line, t, i, j) for every line 't i j' between p and end,
+    // where line points to the start of the line. Other lines are skipped.
+    // Slices of length dt have to be numbered by a NODE.
+    template < typename F >
+    void for_each_contact(const char *p, const char *end, size_t dt, F f)
+    {
+        while (p < end)
+        {
+            const char *line = p;
+            const char *line_end = (const char *) memchr(p, '\n', end-p);
+            if (!line_end)
+                line_end = end;
+
+            while (p < line_end && is_blank(*p))
+                ++p;
+
+            if (p < line_end && (is_digit(*p) || *p == '-'))
+            {
+                NODE_ID t, i, j;
+                if (!parse_integer(p, line_end, t) ||
+                    !parse_integer(p, line_end, i) ||
+                    !parse_integer(p, line_end, j)
+                   )
+                    throw invalid_argument("Line '" + string(line, line_end) + "' is not of the form 't i j' with integers 0 <= t,i,j < 2^64");
+                if (t / dt >= numeric_limits < NODE >::max())
+                    throw invalid_argument("Line '" + string(line, line_end) + "' lies beyond the last slice a NODE can number");
+                f(line, t, i, j);
+            }
+
+            p = line_end + 1;
+        }
+    }
+
+    void parse_chunk(const char *p, const char *end, size_t dt, TijChunk &chunk)
+    {
+        // a rough guess of the number of lines avoids most reallocations
+        size_t expected = (end - p) / 12;
+        chunk.slices.reserve(expected);
+        chunk.i.reserve(expected);
+        chunk.j.reserve(expected);
+
+        for_each_contact(p, end, dt, [&](const char *, NODE_ID t, NODE_ID i, NODE_ID j)
+        {
+            chunk.t_max = max(chunk.t_max, t);
+            chunk.slices.push_back(t / dt);
+            chunk.i.push_back(chunk.index.node(i));
+            chunk.j.push_back(chunk.index.node(j));
+        });
+    }
+}
+
+NetworkFile load_tij(const string &filename, size_t dt, size_t n_threads)
+{
+    if (dt == 0)
+        throw invalid_argument("dt has to be positive");
+
+    auto start = chrono::steady_clock::now();
+
+    NetworkFile result;
+    result.dt = dt;
+    MappedFile file(filename);
+    result.bytes = file.size();
+
+    //-------------------------------------------------------------------------------------
+    // Split at line ends into one chunk per thread (at least 1MB each) and parse
+    //-------------------------------------------------------------------------------------
+    size_t number_of_chunks = number_of_threads(n_threads, file.size() / (1 << 20) + 1);
+    vector < const char * > bounds(number_of_chunks+1);
+    const char *end = file.data() + file.size();
+    bounds[0] = file.data();
+    bounds[number_of_chunks] = end;
+    for(size_t k = 1; k < number_of_chunks; ++k)
+    {
+        const char *p = max(bounds[k-1], file.data() + file.size() / number_of_chunks * k);
+        const char *line_end = (const char *) memchr(p, '\n', end-p);
+        bounds[k] = line_end ? line_end+1 : end;
+    }
+
+    vector < TijChunk > chunks(number_of_chunks);
+    parallel_for(number_of_chunks, number_of_chunks, [&](size_t k, size_t)
+    {
+        parse_chunk(bounds[k], bounds[k+1], dt, chunks[k]);
+    });
+
+    //-------------------------------------------------------------------------------------
+    // Number the nodes in the order of their labels
+    //-------------------------------------------------------------------------------------
+    vector < NODE_ID > node_ids;
+    for(auto const &chunk: chunks)
+        node_ids.insert(node_ids.end(), chunk.index.labels.begin(), chunk.index.labels.end());
+    sort(node_ids.begin(), node_ids.end());
+    node_ids.erase(unique(node_ids.begin(), node_ids.end()), node_ids.end());
+    size_t N = node_ids.size();
+    if (N > numeric_limits < NODE >::max())
+        throw invalid_argument("The file contains more nodes than a NODE can number");
+
+    //-------------------------------------------------------------------------------------
+    // Renumber the contacts of every chunk and concatenate them
+    //-------------------------------------------------------------------------------------
+    vector < size_t > chunk_offsets(number_of_chunks+1,0);
+    NODE_ID t_max = 0;
+    for(size_t k = 0; k < number_of_chunks; ++k)
+    {
+        chunk_offsets[k+1] = chunk_offsets[k] + chunks[k].slices.size();
+        t_max = max(t_max, chunks[k].t_max);
+    }
+    size_t number_of_contacts = chunk_offsets[number_of_chunks];
+    result.T_data = number_of_contacts > 0 ? t_max+1 : 0;
+    size_t number_of_slices = (result.T_data + dt - 1) / dt;
+
+    NODES slices(number_of_contacts), i(number_of_contacts), j(number_of_contacts);
+    parallel_for(number_of_chunks, number_of_chunks, [&](size_t k, size_t)
+    {
+        TijChunk &chunk = chunks[k];
+        NODES renumber(chunk.index.labels.size());
+        for(size_t n = 0; n < renumber.size(); ++n)
+            renumber[n] = lower_bound(node_ids.begin(), node_ids.end(), chunk.index.labels[n]) - node_ids.begin();
+
+        size_t offset = chunk_offsets[k];
+        copy(chunk.slices.begin(), chunk.slices.end(), slices.begin()+offset);
+        for(size_t e = 0; e < chunk.i.size(); ++e)
+        {
+            i[offset+e] = renumber[chunk.i[e]];
+            j[offset+e] = renumber[chunk.j[e]];
+        }
+        chunk = TijChunk();
+    });
+
+    result.network = TemporalNetwork::from_tij_arrays(N, slices.data(), i.data(), j.data(), number_of_contacts, number_of_slices, n_threads);
+    result.node_ids = move(node_ids);
+
+    chrono::duration < double > elapsed = chrono::steady_clock::now() - start;
+    result.load_time = elapsed.count();
+
+    return result;
+}
+
+//======================================================================
+// Binary network files
+//======================================================================
+static_assert(sizeof(size_t) == 8 && sizeof(NODE) == 4 && sizeof(COUNTER) == 4 && sizeof(CONTACT) == 8,
+              "The binary network format is mapped directly onto size_t, NODE, COUNTER and CONTACT");
+
+namespace {
+
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    size_t padded(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+    // array of length elements at offset in data, which owner keeps alive;
+    // moves offset behind it
+    template < typename T >
+    SharedArray < T > mapped_array(const shared_ptr < const void > &owner, const char *data, size_t &offset, size_t length)
+    {
+        SharedArray < T > array(owner, (const T *) (data + offset), length);
+        offset += padded(length * sizeof(T));
+        return array;
+    }
+
+    // byte offsets of the arrays in a binary network file
+    struct NetworkFileLayout
+    {
+        size_t node_ids, slice_offsets, contacts, slice_nodes, slice_node_offsets, incidence_offsets, incidence;
+        size_t size; // of the whole file
+    };
+
+    NetworkFileLayout layout_of(const NetworkFileHeader &header)
+    {
+        size_t S = header.number_of_slices, C = header.number_of_contacts, M = header.number_of_slice_nodes;
+        NetworkFileLayout layout;
+        layout.node_ids = padded(sizeof(header));
+        layout.slice_offsets = layout.node_ids + padded(header.N * sizeof(NODE_ID));
+        layout.contacts = layout.slice_offsets + padded((S+1) * sizeof(size_t));
+        layout.slice_nodes = layout.contacts + padded(C * sizeof(CONTACT));
+        layout.slice_node_offsets = layout.slice_nodes + padded(M * sizeof(NODE));
+        layout.incidence_offsets = layout.slice_node_offsets + padded((S+1) * sizeof(size_t));
+        layout.incidence = layout.incidence_offsets + padded((M+S) * sizeof(COUNTER));
+        layout.size = layout.incidence + padded(2*C * sizeof(COUNTER));
+        return layout;
+    }
+
+    // throws if the first bytes of a file of the given size are not a header this build reads
+    NetworkFileHeader read_header(const char *data, size_t size, const string &filename)
+    {
+        NetworkFileHeader header;
+        if (size < sizeof(header) || memcmp(data, NETWORK_FILE_MAGIC, sizeof(NETWORK_FILE_MAGIC)) != 0)
+            throw invalid_argument("File " + filename + " is not a binary network file");
+        memcpy(&header, data, sizeof(header));
+        if (header.byte_order != BYTE_ORDER_MARK)
+            throw invalid_argument("File " + filename + " was written on a machine with a different byte order");
+        if (header.version < 1 || header.version > NETWORK_FILE_VERSION)
+            throw invalid_argument("File " + filename + " has version " + to_string(header.version)
+                                   + ", this build reads versions up to " + to_string(NETWORK_FILE_VERSION));
+
+        size_t expected = layout_of(header).size;
+        if (size != expected)
+            throw invalid_argument("File " + filename + " is truncated or corrupt (" + to_string(size)
+                                   + " bytes instead of " + to_string(expected) + ")");
+        return header;
+    }
+
+    // tells the formats apart by the magic bytes
+    bool is_network_file(const string &filename)
+    {
+        char magic[sizeof(NETWORK_FILE_MAGIC)] = { 0 };
+        ifstream input(filename, ios::binary);
+        if (!input)
+            throw runtime_error("File " + filename + " cannot be read");
+        input.read(magic, sizeof(magic));
+        return memcmp(magic, NETWORK_FILE_MAGIC, sizeof(magic)) == 0;
+    }
+
+    void check_dt(const string &filename, size_t file_dt, size_t dt)
+    {
+        if (dt > 0 && dt != file_dt)
+            throw invalid_argument("File " + filename + " was converted with dt = " + to_string(file_dt)
+                                   + ", not dt = " + to_string(dt));
+    }
+
+    NetworkFileHeader header_of(const NetworkFile &file)
+    {
+        NetworkFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, NETWORK_FILE_MAGIC, sizeof(header.magic));
+        header.version = NETWORK_FILE_VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.N = file.network.number_of_nodes();
+        header.T_data = file.T_data;
+        header.dt = file.dt;
+        header.number_of_slices = file.network.number_of_slices();
+        header.number_of_contacts = file.network.number_of_contacts();
+        header.number_of_slice_nodes = file.network.arrays().slice_nodes.size();
+
+        if (file.node_ids.size() != header.N)
+            throw invalid_argument("node_ids has to hold one label per node");
+        return header;
+    }
+
+    // Passes the header and the arrays in the order of the format to
+    // write(data, bytes), which pads each of them to a multiple of 8 bytes.
+    template < typename WRITE >
+    void write_network(const NetworkFileHeader &header, const NetworkFile &file, WRITE write)
+    {
+        const TemporalNetwork::Arrays &arrays = file.network.arrays();
+        write(&header, sizeof(header));
+        write(file.node_ids.data(), file.node_ids.size() * sizeof(NODE_ID));
+        write(arrays.slice_offsets.data(), arrays.slice_offsets.size() * sizeof(size_t));
+        write(arrays.contacts.data(), arrays.contacts.size() * sizeof(CONTACT));
+        write(arrays.slice_nodes.data(), arrays.slice_nodes.size() * sizeof(NODE));
+        write(arrays.slice_node_offsets.data(), arrays.slice_node_offsets.size() * sizeof(size_t));
+        write(arrays.incidence_offsets.data(), arrays.incidence_offsets.size() * sizeof(COUNTER));
+        write(arrays.incidence.data(), arrays.incidence.size() * sizeof(COUNTER));
+    }
+
+    // Writes the format to destination, which holds layout_of(header).size
+    // bytes that are zero.
+    void write_network(char *destination, const NetworkFileHeader &header, const NetworkFile &file)
+    {
+        size_t offset = 0;
+        write_network(header, file, [&](const void *data, size_t bytes)
+        {
+            if (bytes > 0)
+                memcpy(destination + offset, data, bytes);
+            offset += padded(bytes);
+        });
+    }
+
+    // Network on the arrays of a binary network in data, which owner
+    // keeps alive. Throws like read_header, and if the arrays are not a
+    // network (see TemporalNetwork::from_arrays).
+    NetworkFile map_network(const shared_ptr < const void > &owner, const char *data, size_t size, const string &filename, bool check_contents)
+    {
+        NetworkFileHeader header = read_header(data, size, filename);
+        size_t S = header.number_of_slices, C = header.number_of_contacts, M = header.number_of_slice_nodes;
+
+        NetworkFile result;
+        size_t offset = layout_of(header).node_ids;
+        result.node_ids = mapped_array < NODE_ID >(owner, data, offset, header.N);
+        TemporalNetwork::Arrays arrays;
+        arrays.slice_offsets = mapped_array < size_t >(owner, data, offset, S+1);
+        arrays.contacts = mapped_array < CONTACT >(owner, data, offset, C);
+        arrays.slice_nodes = mapped_array < NODE >(owner, data, offset, M);
+        arrays.slice_node_offsets = mapped_array < size_t >(owner, data, offset, S+1);
+        arrays.incidence_offsets = mapped_array < COUNTER >(owner, data, offset, M+S);
+        arrays.incidence = mapped_array < COUNTER >(owner, data, offset, 2*C);
+
+        try
+        {
+            result.network = TemporalNetwork::from_arrays(header.N, arrays, check_contents);
+        }
+        catch (const invalid_argument &error)
+        {
+            throw invalid_argument("File " + filename + " is corrupt: " + error.what());
+        }
+        result.T_data = header.T_data;
+        result.dt = header.dt;
+        result.bytes = size;
+        return result;
+    }
+}
+
+void save_network(const string &filename, const NetworkFile &file)
+{
+    NetworkFileHeader header = header_of(file);
+
+    ofstream output(filename, ios::binary);
+    if (!output)
+        throw runtime_error("File " + filename + " cannot be written");
+
+    write_network(header, file, [&output](const void *data, size_t bytes)
+    {
+        static const char zeros[8] = { 0 };
+        output.write((const char *) data, bytes);
+        output.write(zeros, padded(bytes) - bytes);
+    });
+
+    output.close();
+    if (!output)
+        throw runtime_error("File " + filename + " cannot be written");
+}
+
+NetworkFile load_network(const string &filename)
+{
+    auto start = chrono::steady_clock::now();
+
+    shared_ptr < MappedFile > file = make_shared < MappedFile >(filename);
+    NetworkFile result = map_network(file, file->data(), file->size(), filename, false);
+
+    chrono::duration < double > elapsed = chrono::steady_clock::now() - start;
+    result.load_time = elapsed.count();
+
+    return result;
+}
+
+NetworkFile open_network(const string &filename, size_t dt, size_t n_threads)
+{
+    if (!is_network_file(filename))
+        return load_tij(filename, dt > 0 ? dt : 1, n_threads);
+
+    NetworkFile result = load_network(filename);
+    check_dt(filename, result.dt, dt);
+    return result;
+}
+
+//======================================================================
+// Binary networks in memory
+//======================================================================
+namespace {
+
+    // the network with nodes labelled 0,...,N-1 and one slice per dt
+    NetworkFile unlabelled(const TemporalNetwork &network)
+    {
+        NetworkFile file;
+        file.network = network;
+        vector < NODE_ID > node_ids(network.number_of_nodes());
+        for(size_t n = 0; n < node_ids.size(); ++n)
+            node_ids[n] = n;
+        file.node_ids = SharedArray < NODE_ID >(move(node_ids));
+        file.T_data = network.number_of_slices();
+        return file;
+    }
+
+    //------------------------------------------------------------------
+    // POSIX shared memory segment, mapped as long as the object lives
+    //------------------------------------------------------------------
+    class SharedMemorySegment {
+        public:
+            // Creates a new segment of size bytes (zero) and passes its
+            // memory to fill(char *).
+            template < typename FILL >
+            SharedMemorySegment(size_t size, FILL fill) : first(nullptr), length(size), creator(getpid())
+            {
+                static atomic < size_t > segments(0);
+                name = "/DynGillEpi-" + to_string(creator) + "-" + to_string(segments++);
+
+                int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+                if (fd < 0)
+                    throw runtime_error("Shared memory segment " + name + " cannot be created");
+                void * address = MAP_FAILED;
+                if (ftruncate(fd, length) == 0)
+                    address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd);
+                if (address == MAP_FAILED)
+                {
+                    shm_unlink(name.c_str());
+                    throw runtime_error("Shared memory segment " + name + " cannot be created with "
+                                        + to_string(length) + " bytes");
+                }
+                first = (char *) address;
+
+                try
+                {
+                    fill(first);
+                }
+                catch(...)
+                {
+                    munmap(first, length);
+                    shm_unlink(name.c_str());
+                    throw;
+                }
+                register_segment();
+            }
+
+            // Maps the existing segment of the given name.
+            explicit SharedMemorySegment(const string &name) : first(nullptr), length(0), name(name), creator(0)
+            {
+                int fd = shm_open(name.c_str(), O_RDONLY, 0);
+                if (fd < 0)
+                    throw runtime_error("Shared memory segment " + name + " does not exist (anymore)");
+                struct stat status;
+                void * address = MAP_FAILED;
+                if (fstat(fd, &status) == 0 && status.st_size > 0)
+                {
+                    length = status.st_size;
+                    address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+                }
+                close(fd);
+                if (address == MAP_FAILED)
+                    throw runtime_error("Shared memory segment " + name + " cannot be mapped to memory");
+                first = (char *) address;
+                register_segment();
+            }
+
+            // Only the creating process removes the name, not a child that
+            // inherited the object through fork.
+            ~SharedMemorySegment()
+            {
+                {
+                    lock_guard < mutex > lock(registry_mutex());
+                    registry().erase(this);
+                }
+                munmap(first, length);
+                if (creator == getpid())
+                    shm_unlink(name.c_str());
+            }
+
+            SharedMemorySegment(const SharedMemorySegment &) = delete;
+            SharedMemorySegment & operator=(const SharedMemorySegment &) = delete;
+
+            const char * data() const { return first; }
+            size_t size() const { return length; }
+
+            // name of the segment that owner is, empty if it is none
+            static string name_of(const void *owner)
+            {
+                lock_guard < mutex > lock(registry_mutex());
+                auto segment = registry().find(owner);
+                return segment == registry().end() ? string() : segment->second;
+            }
+
+        private:
+            char * first;
+            size_t length;
+            string name;
+            pid_t creator; // 0 for an attached segment
+
+            // the segments mapped in this process, by address
+            static map < const void *, string > & registry()
+            {
+                static map < const void *, string > segments;
+                return segments;
+            }
+            static mutex & registry_mutex()
+            {
+                static mutex m;
+                return m;
+            }
+            void register_segment()
+            {
+                lock_guard < mutex > lock(registry_mutex());
+                registry()[this] = name;
+            }
+    };
+
+    TemporalNetwork network_in(const shared_ptr < SharedMemorySegment > &segment, const string &name, bool check_contents)
+    {
+        return map_network(segment, segment->data(), segment->size(), name, check_contents).network;
+    }
+}
+
+string serialize_network(const TemporalNetwork &network)
+{
+    NetworkFile file = unlabelled(network);
+    NetworkFileHeader header = header_of(file);
+    string bytes(layout_of(header).size, 0);
+    write_network(&bytes[0], header, file);
+    return bytes;
+}
+
+TemporalNetwork deserialize_network(const string &bytes)
+{
+    // copied to 8-byte aligned storage, which the arrays point into
+    auto words = make_shared < vector < uint64_t > >((bytes.size() + 7) / 8);
+    memcpy(words->data(), bytes.data(), bytes.size());
+    return map_network(words, (const char *) words->data(), bytes.size(), "(serialized network)", true).network;
+}
+
+TemporalNetwork share_network(const TemporalNetwork &network)
+{
+    NetworkFile file = unlabelled(network);
+    NetworkFileHeader header = header_of(file);
+    auto segment = make_shared < SharedMemorySegment >(layout_of(header).size, [&](char *destination)
+    {
+        write_network(destination, header, file);
+    });
+    return network_in(segment, SharedMemorySegment::name_of(segment.get()), false);
+}
+
+TemporalNetwork attach_network(const string &name)
+{
+    return network_in(make_shared < SharedMemorySegment >(name), name, true);
+}
+
+string shared_memory_name(const TemporalNetwork &network)
+{
+    return SharedMemorySegment::name_of(network.arrays().contacts.storage().get());
+}
+
+//======================================================================
+// Streaming from disk
+//======================================================================
+// Where the blocks of slices come from, one implementation per format
+struct StreamedNetwork::Source {
+    virtual ~Source() {}
+    // slices [first, last) as a network of last-first slices
+    virtual TemporalNetwork read(size_t first, size_t last) const = 0;
+
+    size_t N = 0;
+    size_t number_of_slices = 0;
+    size_t number_of_contacts = 0;
+    size_t max_contacts_per_slice = 0;
+    size_t slices_per_block = 1;
+    size_t T_data = 0;
+    size_t dt = 1;
+    SharedArray < NODE_ID > node_ids;
+};
+
+namespace {
+
+    // File descriptor for reads at given offsets, from any thread
+    class ReadOnlyFile {
+        public:
+            explicit ReadOnlyFile(const string &filename) : filename(filename)
+            {
+                fd = open(filename.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw runtime_error("File " + filename + " cannot be read");
+            }
+            ~ReadOnlyFile() { close(fd); }
+            ReadOnlyFile(const ReadOnlyFile &) = delete;
+            ReadOnlyFile & operator=(const ReadOnlyFile &) = delete;
+
+            size_t size() const
+            {
+                struct stat status;
+                if (fstat(fd, &status) != 0)
+                    throw runtime_error("File " + filename + " cannot be read");
+                return status.st_size;
+            }
+
+            // Reads bytes at offset into destination, throws if the file ends before.
+            void read(void *destination, size_t bytes, size_t offset) const
+            {
+                char *p = (char *) destination;
+                while (bytes > 0)
+                {
+                    ssize_t n = pread(fd, p, bytes, offset);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        throw runtime_error("File " + filename + " cannot be read at byte " + to_string(offset));
+                    p += n;
+                    bytes -= n;
+                    offset += n;
+                }
+            }
+
+            template < typename T >
+            vector < T > read_array(size_t offset, size_t first, size_t length) const
+            {
+                vector < T > array(length);
+                read(array.data(), length * sizeof(T), offset + first * sizeof(T));
+                return array;
+            }
+
+            const string filename;
+
+        private:
+            int fd;
+    };
+
+    //------------------------------------------------------------------
+    // Binary files: the arrays of a block are read and rebased
+    //------------------------------------------------------------------
+    class BinarySource : public StreamedNetwork::Source {
+        public:
+            explicit BinarySource(const string &filename) : file(filename)
+            {
+                size_t size = file.size();
+                char bytes[sizeof(NetworkFileHeader)] = { 0 };
+                file.read(bytes, min(size, sizeof(bytes)), 0);
+                NetworkFileHeader header = read_header(bytes, size, filename);
+                layout = layout_of(header);
+
+                N = header.N;
+                number_of_slices = header.number_of_slices;
+                number_of_contacts = header.number_of_contacts;
+                number_of_slice_nodes = header.number_of_slice_nodes;
+                T_data = header.T_data;
+                dt = header.dt;
+                node_ids = file.read_array < NODE_ID >(layout.node_ids, 0, N);
+
+                // sizes of the slices, read piecewise
+                const size_t piece = 1 << 16;
+                for(size_t s = 0; s < number_of_slices; s += piece)
+                {
+                    vector < size_t > offsets = file.read_array < size_t >(layout.slice_offsets, s, min(piece, number_of_slices-s)+1);
+                    for(size_t k = 0; k+1 < offsets.size(); ++k)
+                    {
+                        if (offsets[k+1] < offsets[k] || offsets[k+1] > number_of_contacts)
+                            throw invalid_argument("File " + filename + " is corrupt (slice_offsets)");
+                        max_contacts_per_slice = max(max_contacts_per_slice, offsets[k+1]-offsets[k]);
+                    }
+                }
+            }
+
+            TemporalNetwork read(size_t first, size_t last) const
+            {
+                vector < size_t > slice_offsets = file.read_array < size_t >(layout.slice_offsets, first, last-first+1);
+                vector < size_t > slice_node_offsets = file.read_array < size_t >(layout.slice_node_offsets, first, last-first+1);
+                size_t c0 = slice_offsets.front(), c1 = slice_offsets.back();
+                size_t m0 = slice_node_offsets.front(), m1 = slice_node_offsets.back();
+                if (c1 < c0 || c1 > number_of_contacts || m1 < m0 || m1 > number_of_slice_nodes)
+                    throw invalid_argument("File " + file.filename + " is corrupt (offsets of slices " + to_string(first)
+                                           + " to " + to_string(last) + ")");
+                for(auto &offset: slice_offsets)
+                    offset -= c0;
+                for(auto &offset: slice_node_offsets)
+                    offset -= m0;
+
+                TemporalNetwork::Arrays arrays;
+                arrays.contacts = file.read_array < CONTACT >(layout.contacts, c0, c1-c0);
+                arrays.slice_nodes = file.read_array < NODE >(layout.slice_nodes, m0, m1-m0);
+                arrays.incidence_offsets = file.read_array < COUNTER >(layout.incidence_offsets, m0+first, (m1+last)-(m0+first));
+                arrays.incidence = file.read_array < COUNTER >(layout.incidence, 2*c0, 2*(c1-c0));
+                arrays.slice_offsets = move(slice_offsets);
+                arrays.slice_node_offsets = move(slice_node_offsets);
+                try
+                {
+                    return TemporalNetwork::from_arrays(N, arrays, true);
+                }
+                catch (const invalid_argument &error)
+                {
+                    throw invalid_argument("File " + file.filename + " is corrupt: " + error.what());
+                }
+            }
+
+        private:
+            ReadOnlyFile file;
+            NetworkFileLayout layout;
+            size_t number_of_slice_nodes;
+    };
+
+    //------------------------------------------------------------------
+    // tij files: one scan indexes the slices, blocks are parsed when read
+    //------------------------------------------------------------------
+    class TijSource : public StreamedNetwork::Source {
+        public:
+            TijSource(const string &filename, size_t dt_) : file(filename)
+            {
+                dt = dt_;
+                NODE_ID t_max = 0;
+                size_t slice_size = 0;
+                {
+                    MappedFile mapping(filename);
+                    const char *begin = mapping.data();
+                    for_each_contact(begin, begin + mapping.size(), dt, [&](const char *line, NODE_ID t, NODE_ID i, NODE_ID j)
+                    {
+                        if (number_of_contacts > 0 && t < t_max)
+                            throw invalid_argument("File " + filename + " has to be sorted by t to be streamed (t = "
+                                                   + to_string(t) + " comes after t = " + to_string(t_max) + ")");
+                        size_t s = t / dt;
+                        if (s+1 > slice_bytes.size())
+                        {
+                            slice_size = 0;
+                            slice_bytes.resize(s+1, line - begin);
+                        }
+                        t_max = t;
+                        max_contacts_per_slice = max(max_contacts_per_slice, ++slice_size);
+                        ++number_of_contacts;
+                        index.node(i);
+                        index.node(j);
+                    });
+                    slice_bytes.push_back(mapping.size());
+                }
+
+                number_of_slices = slice_bytes.size()-1;
+                T_data = number_of_contacts > 0 ? t_max+1 : 0;
+
+                vector < NODE_ID > labels = index.labels;
+                sort(labels.begin(), labels.end());
+                N = labels.size();
+                if (N > numeric_limits < NODE >::max())
+                    throw invalid_argument("The file contains more nodes than a NODE can number");
+                renumber.resize(N);
+                for(size_t n = 0; n < N; ++n)
+                    renumber[index.find(labels[n])] = n;
+                node_ids = move(labels);
+            }
+
+            TemporalNetwork read(size_t first, size_t last) const
+            {
+                vector < char > text(slice_bytes[last] - slice_bytes[first]);
+                file.read(text.data(), text.size(), slice_bytes[first]);
+
+                NODES slices, i, j;
+                for_each_contact(text.data(), text.data() + text.size(), dt, [&](const char *, NODE_ID t, NODE_ID a, NODE_ID b)
+                {
+                    NODE na = index.find(a), nb = index.find(b);
+                    if (t / dt < first || t / dt >= last || na == LabelIndex::NO_NODE || nb == LabelIndex::NO_NODE)
+                        throw runtime_error("File " + file.filename + " has changed while it was streamed");
+                    slices.push_back(t / dt - first);
+                    i.push_back(renumber[na]);
+                    j.push_back(renumber[nb]);
+                });
+                return TemporalNetwork::from_tij_arrays(N, slices.data(), i.data(), j.data(), slices.size(), last-first);
+            }
+
+        private:
+            ReadOnlyFile file;
+            vector < size_t > slice_bytes; // slice s is in bytes [slice_bytes[s], slice_bytes[s+1])
+            LabelIndex index;
+            NODES renumber; // node number of the k-th label in index
+    };
+}
+
+StreamedNetwork::StreamedNetwork(const string &filename, size_t dt, size_t buffer_contacts)
+{
+    shared_ptr < Source > new_source;
+    if (is_network_file(filename))
+    {
+        new_source = make_shared < BinarySource >(filename);
+        check_dt(filename, new_source->dt, dt);
+    }
+    else
+        new_source = make_shared < TijSource >(filename, dt > 0 ? dt : 1);
+
+    size_t slices = buffer_contacts / max < size_t >(1, new_source->max_contacts_per_slice);
+    new_source->slices_per_block = max < size_t >(1, min(slices, new_source->number_of_slices));
+    source = new_source;
+}
+
+size_t StreamedNetwork::number_of_nodes() const { return source->N; }
+size_t StreamedNetwork::number_of_slices() const { return source->number_of_slices; }
+size_t StreamedNetwork::number_of_contacts() const { return source->number_of_contacts; }
+size_t StreamedNetwork::max_contacts_per_slice() const { return source->max_contacts_per_slice; }
+size_t StreamedNetwork::slices_per_block() const { return source->slices_per_block; }
+size_t StreamedNetwork::T_data() const { return source->T_data; }
+size_t StreamedNetwork::dt() const { return source->dt; }
+const SharedArray < NODE_ID > & StreamedNetwork::node_ids() const { return source->node_ids; }
+
+TemporalNetwork StreamedNetwork::read_block(size_t s) const
+{
+    if (s >= source->number_of_slices)
+        throw out_of_range("Slice " + to_string(s) + " is out of range for a network of "
+                           + to_string(source->number_of_slices) + " slices");
+    size_t first = s - s % source->slices_per_block;
+    size_t last = min(first + source->slices_per_block, source->number_of_slices);
+    return source->read(first, last);
+}
+
+StreamedNetwork::Reader & StreamedNetwork::Reader::operator=(const Reader &other)
+{
+    network = other.network;
+    block = TemporalNetwork();
+    block_first = 0;
+    next = future < TemporalNetwork >();
+    return *this;
+}
+
+TemporalNetwork::Slice StreamedNetwork::Reader::slice(size_t s)
+{
+    if (s < block_first || s >= block_first + block.number_of_slices())
+    {
+        size_t B = network->slices_per_block(), S = network->number_of_slices();
+        size_t first = s - s % B;
+        if (next.valid() && next_first == first)
+            block = next.get();
+        else
+        {
+            // a jump (a new realization), the prefetched block is not needed
+            next = future < TemporalNetwork >();
+            block = network->read_block(first);
+        }
+        block_first = first;
+
+        // read the following block while this one is simulated on
+        if (B < S)
+        {
+            next_first = first + B < S ? first + B : 0;
+            StreamedNetwork shared = *network;
+            size_t following = next_first;
+            next = async(launch::async, [shared, following]() { return shared.read_block(following); });
+        }
+    }
+    return block.slice(s - block_first);
+}
@@ -0,0 +1,226 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __NETWORK_FILES_H__
+#define __NETWORK_FILES_H__
+
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <string>
+#include <cstdint>
+#include <future>
+#include <memory>
+
+using namespace std;
+
+typedef unsigned long long NODE_ID; // label of a node as given in a data file
+
+//======================================================================
+// Read-only memory map of a whole file
+//======================================================================
+class MappedFile {
+    public:
+        // Throws runtime_error if the file can not be opened or mapped.
+        explicit MappedFile(const string &filename);
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+
+        const char * data() const { return first; }
+        size_t size() const { return length; }
+
+    private:
+        const char * first;
+        size_t length;
+};
+
+//======================================================================
+// Temporal network read from a file
+//======================================================================
+struct NetworkFile {
+    TemporalNetwork network;
+    SharedArray < NODE_ID > node_ids; // label in the file of node n = 0,...,N-1 (sorted)
+    size_t T_data = 0; // largest t in the data plus one
+    size_t dt = 1; // slice s holds the contacts with s*dt <= t < (s+1)*dt
+    size_t bytes = 0; // size of the file
+    double load_time = 0; // wall time of loading in seconds
+
+    double megabytes_per_second() const { return load_time > 0 ? bytes / load_time / 1e6 : 0; }
+};
+
+// Reads a text file with one contact (t i j) per line, separated by
+// blanks or tabs. Slice s of the network holds the contacts with
+// s*dt <= t < (s+1)*dt in the order of the file, so the lines do not need
+// to be sorted by t. The labels i and j can be any integers below 2^64;
+// they are numbered 0,...,N-1 in increasing order. Lines that do not start
+// with a number (headers, comments) and columns after j are ignored.
+//
+// The file is memory mapped and split into n_threads chunks (0 means one
+// per hardware thread) that are parsed in parallel.
+// Throws runtime_error if the file can not be read and invalid_argument
+// if a line is malformed.
+NetworkFile load_tij(const string &filename, size_t dt = 1, size_t n_threads = 0);
+
+//======================================================================
+// Binary network files
+//======================================================================
+// A binary file holds a network together with the index the engines use,
+// such that it can be memory mapped and used without any parsing. The
+// file starts with the header below, followed by these arrays in order,
+// each padded to a multiple of 8 bytes:
+//     node_ids            N x uint64
+//     slice_offsets       (number_of_slices+1) x uint64
+//     contacts            number_of_contacts x 2 x uint32
+//     slice_nodes         number_of_slice_nodes x uint32
+//     slice_node_offsets  (number_of_slices+1) x uint64
+//     incidence_offsets   (number_of_slice_nodes+number_of_slices) x uint32
+//     incidence           2*number_of_contacts x uint32
+// Numbers are stored in the byte order of the machine that wrote the
+// file; a file written with a different byte order is refused.
+const char NETWORK_FILE_MAGIC[8] = { 'D','G','E','P','I','N','E','T' };
+const uint32_t NETWORK_FILE_VERSION = 1;
+
+struct NetworkFileHeader {
+    char magic[8]; // NETWORK_FILE_MAGIC
+    uint32_t version; // NETWORK_FILE_VERSION
+    uint32_t byte_order; // 0x01020304
+    uint64_t N;
+    uint64_t T_data;
+    uint64_t dt;
+    uint64_t number_of_slices;
+    uint64_t number_of_contacts;
+    uint64_t number_of_slice_nodes;
+};
+
+// Writes a network in the binary format. Throws runtime_error if the file
+// can not be written.
+void save_network(const string &filename, const NetworkFile &file);
+
+// Maps a binary network file into memory. The network and node_ids point
+// into the mapping, which stays open as long as any copy of them exists.
+// Throws runtime_error if the file can not be read and invalid_argument
+// if it is not a binary network file of a version this build can read,
+// or if its sizes or offsets do not fit. The contacts themselves are not
+// checked, such that opening takes no time whatever the size.
+NetworkFile load_network(const string &filename);
+
+// Opens either a binary network file or a tij file, told apart by the
+// first bytes. dt and n_threads are passed on to load_tij (dt = 0 means
+// dt = 1). A binary file has been sliced with some dt already, it is
+// refused (invalid_argument) if a different dt > 0 is asked for.
+NetworkFile open_network(const string &filename, size_t dt = 0, size_t n_threads = 0);
+
+//======================================================================
+// Binary networks in memory
+//======================================================================
+// A network in the binary format with nodes labelled 0,...,N-1, e.g. for
+// pickling. deserialize_network copies the bytes once and uses the
+// arrays in place; it throws invalid_argument like load_network, and
+// also checks the contacts (see TemporalNetwork::from_arrays).
+string serialize_network(const TemporalNetwork &network);
+TemporalNetwork deserialize_network(const string &bytes);
+
+// Copies a network into a new POSIX shared memory segment in the binary
+// format, such that other processes can map it by name with
+// attach_network instead of receiving a copy. The name is removed once
+// the last copy of the returned network in this process is gone; other
+// processes keep the mappings they made until then. Throws runtime_error
+// if the segment can not be created or does not exist, attach_network
+// throws invalid_argument like deserialize_network.
+TemporalNetwork share_network(const TemporalNetwork &network);
+TemporalNetwork attach_network(const string &name);
+
+// Name of the shared memory segment a network lives in, empty if it is
+// not in shared memory.
+string shared_memory_name(const TemporalNetwork &network);
+
+//======================================================================
+// Temporal network read from disk while the simulation runs
+//======================================================================
+// For data sets that do not fit into memory. Only the size of the network
+// and the node labels are kept, the slices are read in blocks of about
+// buffer_contacts contacts (but at least one slice) when the engine asks
+// for them. Every engine holds two blocks: the one it simulates on and the
+// following one, which is read by a background thread in the meantime.
+// After the last slice, the reading starts over at the first one.
+//
+// Both formats of open_network can be streamed. A binary file is read as
+// it is; a tij file is scanned once on construction to index where each
+// slice starts, so its lines have to be sorted by t (invalid_argument
+// otherwise) and every block is parsed again whenever it is read.
+// Copies share the file.
+class StreamedNetwork {
+    public:
+        // Throws like open_network.
+        StreamedNetwork(const string &filename, size_t dt = 0, size_t buffer_contacts = 1 << 20);
+
+        size_t number_of_nodes() const;
+        size_t number_of_slices() const;
+        size_t number_of_contacts() const;
+        size_t max_contacts_per_slice() const;
+        size_t slices_per_block() const;
+        size_t T_data() const; // largest t in the data plus one
+        size_t dt() const;
+        const SharedArray < NODE_ID > & node_ids() const; // label in the file of node n (sorted)
+
+        // Reads the block of slices that contains slice s into memory, as
+        // a network whose slice 0 is the first slice of the block. May be
+        // called from several threads at once.
+        TemporalNetwork read_block(size_t s) const;
+
+        //------------------------------------------------------------------
+        // Sequential access for one engine, see TemporalNetwork::Reader
+        //------------------------------------------------------------------
+        class Reader {
+            public:
+                Reader(const StreamedNetwork *network = nullptr) : network(network) {}
+                // a copy starts without buffers
+                Reader(const Reader &other) : network(other.network) {}
+                Reader & operator=(const Reader &other);
+
+                // The slice stays valid until the next call.
+                TemporalNetwork::Slice slice(size_t s);
+                // runs of identical slices end with the block
+                size_t repeats(size_t s) { return block.repeats(s - block_first); }
+                // the end of the block if n has no contact in the rest of it
+                size_t next_contact(NODE n, size_t s) { return block.next_contact(n, s - block_first) + block_first; }
+
+            private:
+                const StreamedNetwork *network;
+                TemporalNetwork block; // the block slice() hands out from
+                size_t block_first = 0; // its first slice
+                // the following block, being read (the destructor of a
+                // future from async waits for the reading to finish)
+                future < TemporalNetwork > next;
+                size_t next_first = 0;
+        };
+
+        // where the blocks come from, one kind per file format
+        struct Source;
+
+    private:
+        shared_ptr < const Source > source;
+};
+
+#endif
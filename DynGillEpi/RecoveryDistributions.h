@@ -0,0 +1,365 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __RECOVERY_DISTRIBUTIONS_H__
+#define __RECOVERY_DISTRIBUTIONS_H__
+
+#include <Utilities.h>
+#include <limits>
+
+using namespace std;
+
+//======================================================================
+// Recovery-time distributions
+//======================================================================
+// Constant recovery rate mu per time step (Poisson process)
+struct ExponentialRecovery {
+    explicit ExponentialRecovery(double mu) : mu(mu) {}
+    double mu;
+};
+
+// Every other distribution provides
+//
+//     TabulatedHazard tabulate() const;
+//
+// the hazard rate (probability per time of recovering at a given age of
+// the infection), constant on the intervals [ages[m], ages[m+1]) of a grid
+// of ages starting at ages[0] = 0. The last rate holds for all ages beyond
+// the grid. A distribution is tabulated once per engine, such that a
+// simulation only looks up rates, whatever the distribution.
+//
+// The tables end where the survival probability falls below
+// exp(-CUMULATIVE_HAZARD_MAX).
+const double CUMULATIVE_HAZARD_MAX = 50.;
+
+struct TabulatedHazard {
+    vector < double > ages; // lower ends of the intervals
+    vector < double > rates; // hazard rate per interval
+
+    size_t size() const { return rates.size(); }
+    double rate(size_t m) const { return rates[m]; }
+
+    // upper end of interval m (infinity for the last one)
+    double end(size_t m) const
+    {
+        return m+1 < ages.size() ? ages[m+1] : numeric_limits < double >::infinity();
+    }
+
+    // interval containing age, searching forward from interval m
+    size_t interval(double age, size_t m) const
+    {
+        while (age >= end(m))
+            m++;
+        return m;
+    }
+};
+
+// Weibull distributed recovery times with scale 1/mu0 and shape k, i.e.,
+// hazard k*mu0^k*age^(k-1) and cumulative hazard (mu0*age)^k.
+//
+// The hazard is tabulated on a geometric grid of ages starting at
+// precision/mu0, consecutive grid points differ by a factor
+// (1+precision)^(1/|k-1|), such that the exact hazard changes by a factor
+// 1+precision per interval. Every interval gets the mean hazard over the
+// interval, so the rate of a node is within a factor 1+precision of its
+// exact hazard (beyond the first interval) and the probability to recover
+// until the end of an interval is exact. The mean is finite on [0,
+// precision/mu0) also for k < 1.
+struct WeibullRecovery {
+    WeibullRecovery(double mu0, double k, double precision)
+        : mu0(mu0), k(k), precision(precision)
+    {}
+
+    double hazard(double age) const { return k*pow(mu0,k)*pow(age,k-1.); }
+    double cumulative_hazard(double age) const { return pow(mu0*age,k); }
+
+    TabulatedHazard tabulate() const
+    {
+        if (!(mu0 > 0) || !(k > 0) || !(precision > 0))
+            throw invalid_argument("recovery_rate_per_dt, shape and precision have to be positive");
+
+        const size_t max_size = 1000000;
+
+        double first = precision/mu0;
+        double last = pow(CUMULATIVE_HAZARD_MAX,1./k)/mu0;
+        double growth = pow(1.+precision,1./fabs(k-1.)); // inf for k = 1
+
+        TabulatedHazard table;
+        table.ages.push_back(0.);
+        for(double age = first; age < last && isfinite(age) && table.ages.size() < max_size; age *= growth)
+            table.ages.push_back(age);
+        for(size_t m = 0; m+1 < table.ages.size(); ++m)
+            table.rates.push_back((cumulative_hazard(table.ages[m+1])-cumulative_hazard(table.ages[m]))/(table.ages[m+1]-table.ages[m]));
+        table.rates.push_back(hazard(table.ages.back()));
+        return table;
+    }
+
+    double mu0;
+    double k;
+    double precision;
+};
+
+// Tabulates a hazard that is known in closed form: the first interval is
+// [0, first), every further interval is as long as possible while the
+// hazard at its middle and end differs by at most a fraction precision
+// from the hazard at its start (or from min_hazard, if that is larger).
+// Every interval gets its mean hazard from the cumulative hazard. The
+// grid ends at last.
+template < typename HAZARD, typename CUMULATIVE_HAZARD >
+TabulatedHazard tabulate_hazard(HAZARD hazard,
+                                CUMULATIVE_HAZARD cumulative_hazard,
+                                double first,
+                                double last,
+                                double precision,
+                                double min_hazard
+                               )
+{
+    const size_t max_size = 1000000;
+
+    auto within_precision = [&](double a, double b)
+    {
+        double h = hazard(a);
+        double tolerance = precision*max(h,min_hazard);
+        return fabs(hazard(b)-h) <= tolerance && fabs(hazard(0.5*(a+b))-h) <= tolerance;
+    };
+
+    TabulatedHazard table;
+    table.ages.push_back(0.);
+    for(double age = first; age < last && table.ages.size() < max_size; )
+    {
+        table.ages.push_back(age);
+
+        // double the step as long as it holds, then bisect between the
+        // longest step that holds and the shortest that does not
+        double good = 0.;
+        double bad = age*precision;
+        while (age+bad < last && within_precision(age,age+bad))
+        {
+            good = bad;
+            bad *= 2.;
+        }
+        if (age+bad >= last && within_precision(age,last))
+            good = last-age;
+        else
+            for(size_t i = 0; i < 30; ++i)
+            {
+                double step = 0.5*(good+bad);
+                if (within_precision(age,age+step))
+                    good = step;
+                else
+                    bad = step;
+            }
+
+        // a jump of the hazard is crossed with a tiny step
+        age += max(good, age*precision*1e-6);
+    }
+
+    for(size_t m = 0; m+1 < table.ages.size(); ++m)
+        table.rates.push_back((cumulative_hazard(table.ages[m+1])-cumulative_hazard(table.ages[m]))/(table.ages[m+1]-table.ages[m]));
+    table.rates.push_back(hazard(table.ages.back()));
+    return table;
+}
+
+// Age at which the cumulative hazard reaches cumulative_hazard_max, found
+// by doubling from age
+template < typename CUMULATIVE_HAZARD >
+double age_of_cumulative_hazard(CUMULATIVE_HAZARD cumulative_hazard, double cumulative_hazard_max, double age)
+{
+    while (cumulative_hazard(age) < cumulative_hazard_max && isfinite(age))
+        age *= 2.;
+    return age;
+}
+
+// Logarithm of the regularized upper incomplete gamma function
+// Q(k,x) = Gamma(k,x)/Gamma(k), from the series of P = 1-Q for x < k+1
+// and the continued fraction of Q otherwise (Numerical Recipes, 6.2).
+inline double log_gamma_Q(double k, double x)
+{
+    if (x <= 0)
+        return 0.;
+
+    const double eps = 1e-15;
+    const double tiny = 1e-300;
+    double log_prefactor = k*log(x) - x - lgamma(k);
+    if (x < k+1.)
+    {
+        double term = 1./k;
+        double sum = term;
+        for(size_t n = 1; n < 1000 && fabs(term) > fabs(sum)*eps; ++n)
+        {
+            term *= x/(k+n);
+            sum += term;
+        }
+        return log1p(-exp(log_prefactor)*sum);
+    }
+
+    double b = x+1.-k;
+    double c = 1./tiny;
+    double d = 1./b;
+    double h = d;
+    for(size_t n = 1; n < 1000; ++n)
+    {
+        double a = -(double) n*((double) n-k);
+        b += 2.;
+        d = a*d + b;
+        if (fabs(d) < tiny)
+            d = tiny;
+        c = b + a/c;
+        if (fabs(c) < tiny)
+            c = tiny;
+        d = 1./d;
+        double delta = d*c;
+        h *= delta;
+        if (fabs(delta-1.) < eps)
+            break;
+    }
+    return log_prefactor + log(h);
+}
+
+// Gamma distributed recovery times with shape k and scale theta (mean
+// k*theta time steps). The hazard is tabulated by tabulate_hazard from
+// precision*theta on.
+struct GammaRecovery {
+    GammaRecovery(double k, double theta, double precision)
+        : k(k), theta(theta), precision(precision)
+    {}
+
+    double hazard(double age) const
+    {
+        double x = age/theta;
+        return exp((k-1.)*log(x) - x - lgamma(k) - log(theta) - log_gamma_Q(k,x));
+    }
+
+    double cumulative_hazard(double age) const { return -log_gamma_Q(k,age/theta); }
+
+    TabulatedHazard tabulate() const
+    {
+        if (!(k > 0) || !(theta > 0) || !(precision > 0))
+            throw invalid_argument("shape, scale and precision have to be positive");
+
+        auto h = [this](double age) { return hazard(age); };
+        auto H = [this](double age) { return cumulative_hazard(age); };
+        double last = age_of_cumulative_hazard(H, CUMULATIVE_HAZARD_MAX, k*theta);
+        return tabulate_hazard(h, H, precision*theta, last, precision, precision*H(last)/last);
+    }
+
+    double k;
+    double theta;
+    double precision;
+};
+
+// Log-normally distributed recovery times, the logarithm of the recovery
+// time being normally distributed with mean log(median) and standard
+// deviation sigma. The hazard is tabulated by tabulate_hazard from
+// precision*median on.
+struct LogNormalRecovery {
+    LogNormalRecovery(double median, double sigma, double precision)
+        : median(median), sigma(sigma), precision(precision)
+    {}
+
+    double hazard(double age) const
+    {
+        double z = log(age/median)/sigma;
+        return exp(-0.5*z*z)/(age*sigma*sqrt(2.*acos(-1.))) / (0.5*erfc(z/sqrt(2.)));
+    }
+
+    double cumulative_hazard(double age) const
+    {
+        if (age <= 0)
+            return 0.;
+        return -log(0.5*erfc(log(age/median)/sigma/sqrt(2.)));
+    }
+
+    TabulatedHazard tabulate() const
+    {
+        if (!(median > 0) || !(sigma > 0) || !(precision > 0))
+            throw invalid_argument("median, sigma and precision have to be positive");
+
+        auto h = [this](double age) { return hazard(age); };
+        auto H = [this](double age) { return cumulative_hazard(age); };
+        double last = age_of_cumulative_hazard(H, CUMULATIVE_HAZARD_MAX, median);
+        return tabulate_hazard(h, H, precision*median, last, precision, precision*H(last)/last);
+    }
+
+    double median;
+    double sigma;
+    double precision;
+};
+
+// Recovery times distributed as in a histogram of observed infectious
+// periods, histogram[j] counting the periods in [j*bin_width,
+// (j+1)*bin_width) time steps. The hazard is constant within a bin and
+// such that the fraction of periods longer than each bin edge is exact,
+// i.e., the histogram bins are the intervals of the table. The periods in
+// the last non-empty bin are taken as uniformly distributed over the bin.
+struct EmpiricalRecovery {
+    EmpiricalRecovery(const vector < double > &histogram, double bin_width)
+        : histogram(histogram), bin_width(bin_width)
+    {}
+
+    TabulatedHazard tabulate() const
+    {
+        double total = 0.;
+        for(auto const &count: histogram)
+        {
+            if (!(count >= 0))
+                throw invalid_argument("The histogram of recovery times must not have negative entries");
+            total += count;
+        }
+        if (!(total > 0) || !(bin_width > 0))
+            throw invalid_argument("The histogram of recovery times must not be empty and bin_width has to be positive");
+
+        TabulatedHazard table;
+        double longer = total; // number of periods longer than the start of bin j
+        for(size_t j = 0; j < histogram.size() && longer > total*1e-12; ++j)
+        {
+            double next = longer - histogram[j];
+            if (next > total*1e-12)
+            {
+                table.ages.push_back(j*bin_width);
+                table.rates.push_back(log(longer/next)/bin_width);
+                longer = next;
+                continue;
+            }
+
+            // all remaining nodes recover within the last bin: its hazard
+            // 1/(time left in the bin) is tabulated on intervals that
+            // halve the time left
+            double left = bin_width;
+            for(size_t i = 0; i < 20; ++i)
+            {
+                table.ages.push_back((j+1)*bin_width - left);
+                table.rates.push_back(log(2.)/(0.5*left));
+                left *= 0.5;
+            }
+            break;
+        }
+        return table;
+    }
+
+    vector < double > histogram;
+    double bin_width;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/* Simulates independent realizations of a homogeneous SIR process on
+a temporal network.*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+#include "SIR_Poisson_homogeneous.h"
+
+using namespace std;
+
+//======================================================================
+// Main:
+//======================================================================
+SIR_result
+    SIR_Poisson_homogeneous(const TemporalNetwork &network,
+                            double infection_rate_per_dt,
+                            double recovery_rate_per_dt,
+                            size_t T_simulation,
+                            size_t output_time_resolution,
+                            size_t number_of_simulations,
+                            size_t initial_number_of_infected,
+                            size_t seed,
+                            size_t t_infection_start,
+                            bool verbose,
+                            size_t n_threads,
+                            bool store_realizations,
+                            const vector < double > &quantiles,
+                            bool record_events,
+                            size_t record_every,
+                            double record_min_interval,
+                            const atomic < bool > *cancel
+            )
+{
+    size_t N = network.number_of_nodes();
+    SimulationParameters parameters = simulation_parameters(T_simulation,
+                                                            output_time_resolution,
+                                                            number_of_simulations,
+                                                            initial_number_of_infected,
+                                                            seed,
+                                                            t_infection_start,
+                                                            verbose,
+                                                            n_threads,
+                                                            store_realizations,
+                                                            quantiles,
+                                                            record_events,
+                                                            record_every,
+                                                            record_min_interval
+                                                           );
+
+    //-------------------------------------------------------------------------------------
+    // Simulate:
+    //-------------------------------------------------------------------------------------
+    TemporalGillespie < SIR > engine(network, infection_rate_per_dt, ExponentialRecovery(recovery_rate_per_dt));
+    EnsembleResult ensemble = run_ensemble(engine, parameters, cancel);
+
+    if (verbose)
+    {
+        std::cout << std::endl << "temporal Gillespie---homogeneous & Poissonian SIR: N=" << N << ", beta=" << infection_rate_per_dt << ", mu=" << recovery_rate_per_dt << ", resolution = " << output_time_resolution << std::endl;
+        std::cout << "Simulation time: " << ensemble.simulation_time << ", Stopped: " << ensemble.number_stopped << "/" << number_of_simulations << ", " << ensemble.threads << std::endl;
+    }
+
+    return as_SIR_result(ensemble);
+}
+
+//======================================================================
+// Parameter sweep:
+//======================================================================
+vector < SweepPoint >
+    SIR_Poisson_homogeneous_sweep(const TemporalNetwork &network,
+                                  const vector < double > &infection_rates_per_dt,
+                                  const vector < double > &recovery_rates_per_dt,
+                                  size_t T_simulation,
+                                  size_t number_of_simulations,
+                                  const vector < size_t > &initial_numbers_of_infected,
+                                  size_t seed,
+                                  size_t t_infection_start,
+                                  bool verbose,
+                                  size_t n_threads,
+                                  const atomic < bool > *cancel
+            )
+{
+    SimulationParameters parameters = simulation_parameters(T_simulation,
+                                                            1,
+                                                            number_of_simulations,
+                                                            1, // per point, see Poisson_sweep
+                                                            seed,
+                                                            t_infection_start,
+                                                            verbose,
+                                                            n_threads,
+                                                            false,
+                                                            vector < double >(),
+                                                            false,
+                                                            1,
+                                                            0.
+                                                           );
+
+    auto start = chrono::steady_clock::now();
+    vector < SweepPoint > points = Poisson_sweep < SIR >(network, infection_rates_per_dt, recovery_rates_per_dt, initial_numbers_of_infected, parameters, cancel);
+
+    if (verbose)
+    {
+        std::cout << std::endl << "temporal Gillespie---homogeneous & Poissonian SIR sweep: N=" << network.number_of_nodes() << ", points=" << points.size() << std::endl;
+        std::cout << "Simulation time: " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << ", threads: " << number_of_threads(n_threads, points.size()*number_of_simulations) << std::endl;
+    }
+
+    return points;
+}
@@ -0,0 +1,68 @@
+/* Simulates independent realizations of a homogeneous SIR process on
+a temporal network. Contacts that can not transmit anymore (neither SS
+nor SI) are removed for the rest of a realization, which speeds up the
+late phase of an outbreak. The results follow the same distribution as
+SIR_Poisson_homogeneous.*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+#include "SIR_Poisson_homogeneous_contactRemoval.h"
+
+using namespace std;
+
+//======================================================================
+// Main:
+//======================================================================
+SIR_result
+    SIR_Poisson_homogeneous_contactRemoval(const TemporalNetwork &network,
+                                           double infection_rate_per_dt,
+                                           double recovery_rate_per_dt,
+                                           size_t T_simulation,
+                                           size_t output_time_resolution,
+                                           size_t number_of_simulations,
+                                           size_t initial_number_of_infected,
+                                           size_t seed,
+                                           size_t t_infection_start,
+                                           bool verbose,
+                                           size_t n_threads,
+                                           bool store_realizations,
+                                           const vector < double > &quantiles,
+                                           bool record_events,
+                                           size_t record_every,
+                                           double record_min_interval,
+                                           const atomic < bool > *cancel
+            )
+{
+    size_t N = network.number_of_nodes();
+    SimulationParameters parameters = simulation_parameters(T_simulation,
+                                                            output_time_resolution,
+                                                            number_of_simulations,
+                                                            initial_number_of_infected,
+                                                            seed,
+                                                            t_infection_start,
+                                                            verbose,
+                                                            n_threads,
+                                                            store_realizations,
+                                                            quantiles,
+                                                            record_events,
+                                                            record_every,
+                                                            record_min_interval
+                                                           );
+
+    //-------------------------------------------------------------------------------------
+    // Simulate:
+    //-------------------------------------------------------------------------------------
+    TemporalGillespie < SIR, HomogeneousRates, ContactRemoval > engine(network, infection_rate_per_dt, ExponentialRecovery(recovery_rate_per_dt));
+    EnsembleResult ensemble = run_ensemble(engine, parameters, cancel);
+
+    if (verbose)
+    {
+        std::cout << std::endl << "temporal Gillespie---homogeneous & Poissonian SIR w/ contact removal: N=" << N << ", beta=" << infection_rate_per_dt << ", mu=" << recovery_rate_per_dt << ", resolution = " << output_time_resolution << std::endl;
+        std::cout << "Simulation time: " << ensemble.simulation_time << ", Stopped: " << ensemble.number_stopped << "/" << number_of_simulations << ", " << ensemble.threads << std::endl;
+    }
+
+    return as_SIR_result(ensemble);
+}
@@ -0,0 +1,224 @@
+/* Simulates independent realizations of a non-Markovian SIR process
+with Weibull distributed recovery times on a temporal network, where
+recovery_rate_per_dt (mu0) is the inverse scale and shape (k) the shape
+parameter of the distribution, i.e., a node infected for a time a
+recovers with rate k*mu0^k*a^(k-1). The rate of a node is kept within a
+factor 1+precision of this hazard (see WeibullRecovery), nodes are only
+updated when their rate has drifted that far.
+
+SIR_nonMarkovian_gamma, SIR_nonMarkovian_lognormal and
+SIR_nonMarkovian_empirical simulate the same process with gamma,
+log-normal and empirical distributions of the recovery times, see
+RecoveryDistributions.h. All distributions are tabulated once, a
+simulation costs the same whatever the distribution.*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+#include "SIR_nonMarkovian.h"
+#include <sstream>
+
+using namespace std;
+
+//======================================================================
+// Simulation with any recovery-time distribution:
+//======================================================================
+template < typename RECOVERY >
+SIR_result simulate_nonMarkovian(const TemporalNetwork &network,
+                                 double infection_rate_per_dt,
+                                 const RECOVERY &recovery,
+                                 const string &description,
+                                 size_t T_simulation,
+                                 size_t output_time_resolution,
+                                 size_t number_of_simulations,
+                                 size_t initial_number_of_infected,
+                                 size_t seed,
+                                 size_t t_infection_start,
+                                 bool verbose,
+                                 size_t n_threads,
+                                 bool store_realizations,
+                                 const vector < double > &quantiles,
+                                 bool record_events,
+                                 size_t record_every,
+                                 double record_min_interval,
+                                 const atomic < bool > *cancel
+                                )
+{
+    size_t N = network.number_of_nodes();
+    SimulationParameters parameters = simulation_parameters(T_simulation,
+                                                            output_time_resolution,
+                                                            number_of_simulations,
+                                                            initial_number_of_infected,
+                                                            seed,
+                                                            t_infection_start,
+                                                            verbose,
+                                                            n_threads,
+                                                            store_realizations,
+                                                            quantiles,
+                                                            record_events,
+                                                            record_every,
+                                                            record_min_interval
+                                                           );
+
+    //-------------------------------------------------------------------------------------
+    // Simulate:
+    //-------------------------------------------------------------------------------------
+    TemporalGillespie < SIR, HomogeneousRates, NoPruning, RECOVERY > engine(network, infection_rate_per_dt, recovery);
+    EnsembleResult ensemble = run_ensemble(engine, parameters, cancel);
+
+    if (verbose)
+    {
+        std::cout << std::endl << "temporal Gillespie---non-Markovian SIR: N=" << N << ", beta=" << infection_rate_per_dt << ", " << description << ", resolution = " << output_time_resolution << std::endl;
+        std::cout << "Simulation time: " << ensemble.simulation_time << ", Stopped: " << ensemble.number_stopped << "/" << number_of_simulations << ", " << ensemble.threads << std::endl;
+    }
+
+    return as_SIR_result(ensemble);
+}
+
+#define SIMULATION_PARAMETERS \
+    T_simulation, \
+    output_time_resolution, \
+    number_of_simulations, \
+    initial_number_of_infected, \
+    seed, \
+    t_infection_start, \
+    verbose, \
+    n_threads, \
+    store_realizations, \
+    quantiles, \
+    record_events, \
+    record_every, \
+    record_min_interval, \
+    cancel
+
+//======================================================================
+// Main:
+//======================================================================
+SIR_result
+    SIR_nonMarkovian(const TemporalNetwork &network,
+                     double infection_rate_per_dt,
+                     double recovery_rate_per_dt,
+                     double shape,
+                     double precision,
+                     size_t T_simulation,
+                     size_t output_time_resolution,
+                     size_t number_of_simulations,
+                     size_t initial_number_of_infected,
+                     size_t seed,
+                     size_t t_infection_start,
+                     bool verbose,
+                     size_t n_threads,
+                     bool store_realizations,
+                     const vector < double > &quantiles,
+                     bool record_events,
+                     size_t record_every,
+                     double record_min_interval,
+                     const atomic < bool > *cancel
+            )
+{
+    ostringstream description;
+    description << "mu=" << recovery_rate_per_dt << ", k=" << shape;
+    return simulate_nonMarkovian(network,
+                                 infection_rate_per_dt,
+                                 WeibullRecovery(recovery_rate_per_dt,shape,precision),
+                                 description.str(),
+                                 SIMULATION_PARAMETERS
+                                );
+}
+
+SIR_result
+    SIR_nonMarkovian_gamma(const TemporalNetwork &network,
+                           double infection_rate_per_dt,
+                           double shape,
+                           double scale,
+                           double precision,
+                           size_t T_simulation,
+                           size_t output_time_resolution,
+                           size_t number_of_simulations,
+                           size_t initial_number_of_infected,
+                           size_t seed,
+                           size_t t_infection_start,
+                           bool verbose,
+                           size_t n_threads,
+                           bool store_realizations,
+                           const vector < double > &quantiles,
+                           bool record_events,
+                           size_t record_every,
+                           double record_min_interval,
+                           const atomic < bool > *cancel
+            )
+{
+    ostringstream description;
+    description << "gamma recovery, k=" << shape << ", theta=" << scale;
+    return simulate_nonMarkovian(network,
+                                 infection_rate_per_dt,
+                                 GammaRecovery(shape,scale,precision),
+                                 description.str(),
+                                 SIMULATION_PARAMETERS
+                                );
+}
+
+SIR_result
+    SIR_nonMarkovian_lognormal(const TemporalNetwork &network,
+                               double infection_rate_per_dt,
+                               double median,
+                               double sigma,
+                               double precision,
+                               size_t T_simulation,
+                               size_t output_time_resolution,
+                               size_t number_of_simulations,
+                               size_t initial_number_of_infected,
+                               size_t seed,
+                               size_t t_infection_start,
+                               bool verbose,
+                               size_t n_threads,
+                               bool store_realizations,
+                               const vector < double > &quantiles,
+                               bool record_events,
+                               size_t record_every,
+                               double record_min_interval,
+                               const atomic < bool > *cancel
+            )
+{
+    ostringstream description;
+    description << "log-normal recovery, median=" << median << ", sigma=" << sigma;
+    return simulate_nonMarkovian(network,
+                                 infection_rate_per_dt,
+                                 LogNormalRecovery(median,sigma,precision),
+                                 description.str(),
+                                 SIMULATION_PARAMETERS
+                                );
+}
+
+SIR_result
+    SIR_nonMarkovian_empirical(const TemporalNetwork &network,
+                               double infection_rate_per_dt,
+                               const vector < double > &histogram,
+                               double bin_width,
+                               size_t T_simulation,
+                               size_t output_time_resolution,
+                               size_t number_of_simulations,
+                               size_t initial_number_of_infected,
+                               size_t seed,
+                               size_t t_infection_start,
+                               bool verbose,
+                               size_t n_threads,
+                               bool store_realizations,
+                               const vector < double > &quantiles,
+                               bool record_events,
+                               size_t record_every,
+                               double record_min_interval,
+                               const atomic < bool > *cancel
+            )
+{
+    ostringstream description;
+    description << "empirical recovery, " << histogram.size() << " bins of width " << bin_width;
+    return simulate_nonMarkovian(network,
+                                 infection_rate_per_dt,
+                                 EmpiricalRecovery(histogram,bin_width),
+                                 description.str(),
+                                 SIMULATION_PARAMETERS
+                                );
+}
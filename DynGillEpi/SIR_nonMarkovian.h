@@ -0,0 +1,93 @@
+#ifndef __SIR_NON_MARKOV_H__
+#define __SIR_NON_MARKOV_H__
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+
+SIR_result
+    SIR_nonMarkovian(const TemporalNetwork &network,
+                     double infection_rate_per_dt,
+                     double recovery_rate_per_dt,
+                     double shape,
+                     double precision,
+                     size_t T_simulation,
+                     size_t output_time_resolution,
+                     size_t number_of_simulations = 1,
+                     size_t initial_number_of_infected = 1,
+                     size_t seed = 0,
+                     size_t t_infection_start = 0,
+                     bool verbose = false,
+                     size_t n_threads = 1,
+                     bool store_realizations = true,
+                     const vector < double > &quantiles = vector < double >(),
+                     bool record_events = false,
+                     size_t record_every = 1,
+                     double record_min_interval = 0.,
+                     const atomic < bool > *cancel = nullptr
+            );
+
+SIR_result
+    SIR_nonMarkovian_gamma(const TemporalNetwork &network,
+                           double infection_rate_per_dt,
+                           double shape,
+                           double scale,
+                           double precision,
+                           size_t T_simulation,
+                           size_t output_time_resolution,
+                           size_t number_of_simulations = 1,
+                           size_t initial_number_of_infected = 1,
+                           size_t seed = 0,
+                           size_t t_infection_start = 0,
+                           bool verbose = false,
+                           size_t n_threads = 1,
+                           bool store_realizations = true,
+                           const vector < double > &quantiles = vector < double >(),
+                           bool record_events = false,
+                           size_t record_every = 1,
+                           double record_min_interval = 0.,
+                           const atomic < bool > *cancel = nullptr
+            );
+
+SIR_result
+    SIR_nonMarkovian_lognormal(const TemporalNetwork &network,
+                               double infection_rate_per_dt,
+                               double median,
+                               double sigma,
+                               double precision,
+                               size_t T_simulation,
+                               size_t output_time_resolution,
+                               size_t number_of_simulations = 1,
+                               size_t initial_number_of_infected = 1,
+                               size_t seed = 0,
+                               size_t t_infection_start = 0,
+                               bool verbose = false,
+                               size_t n_threads = 1,
+                               bool store_realizations = true,
+                               const vector < double > &quantiles = vector < double >(),
+                               bool record_events = false,
+                               size_t record_every = 1,
+                               double record_min_interval = 0.,
+                               const atomic < bool > *cancel = nullptr
+            );
+
+SIR_result
+    SIR_nonMarkovian_empirical(const TemporalNetwork &network,
+                               double infection_rate_per_dt,
+                               const vector < double > &histogram,
+                               double bin_width,
+                               size_t T_simulation,
+                               size_t output_time_resolution,
+                               size_t number_of_simulations = 1,
+                               size_t initial_number_of_infected = 1,
+                               size_t seed = 0,
+                               size_t t_infection_start = 0,
+                               bool verbose = false,
+                               size_t n_threads = 1,
+                               bool store_realizations = true,
+                               const vector < double > &quantiles = vector < double >(),
+                               bool record_events = false,
+                               size_t record_every = 1,
+                               double record_min_interval = 0.,
+                               const atomic < bool > *cancel = nullptr
+            );
+
+#endif
@@ -5,14 +5,15 @@ have different susceptibility, infectivity, and recoverability, i.e.,
 beta may depend both the susceptible and the infectious node in contact
 and mu may depend on the infectious node.
 
-Should be compiled with g++ including the boost library and using the
-option -O2, i.e., as
-g++ SIS-Poisson-heterogeneous.cpp -o SIS -O2 -I<path of boost>
+Should be compiled with g++ together with Utilities.cpp,
+TemporalNetwork.cpp and NetworkFiles.cpp using the options -O2 -std=c++14, i.e., as
+g++ SIS-Poisson-heterogeneous.cpp Utilities.cpp TemporalNetwork.cpp NetworkFiles.cpp -o SIS -O2 -std=c++14 -pthread -I.
 
 With the program compiled as SIS, it is called from the shell as:
-./SIS <data> dt beta mu T_simulation ensembleSize outputTimeResolution
+./SIS <data> dt beta mu T_simulation ensembleSize outputTimeResolution [sampler]
 where:
-<data> - path of text file containing contact data (temporal network);
+<data> - path of text file containing contact data (temporal network),
+    or of a binary network file written by convert-tij;
 dt - time-resolution of recorded contact data (time-step length);
 beta - probability per time-step of infection when in contact with an
     infected node;
@@ -21,6 +22,9 @@ T_simulation - length of simulation in number of time-steps;
 ensembleSize - number of independent realizations of the SIR process;
 outputTimeResolution - time-resolution of the average number of infected
     and recovered nodes that the program gives as output.
+sampler - optional, how the transitions are drawn: sum_tree (default),
+    composition_rejection (fastest if the rates span a few orders of
+    magnitude only) or cumulative.
 The lists susceptibilities, infectivities, and recoverabilities give
 multiplicative constants that modify the baseline beta and mu (given in
 the command line when calling the program).
@@ -33,36 +37,12 @@ number of recovered nodes at t=T_simulation-1.*/
 //======================================================================
 #include <string.h>
 #include <stdlib.h>
-#include <math.h>
 #include <iostream>
 #include <fstream>
-#include <boost/random/mersenne_twister.hpp>
-#include <boost/random/variate_generator.hpp>
-#include <boost/random/uniform_int.hpp>
-#include <boost/random/uniform_real.hpp>
-#include <boost/random/exponential_distribution.hpp>
-#include <algorithm> //for sort and unique
-#include <vector>
-#include <iterator>
-#include <ctime>
-
-//======================================================================
-// Typedef
-//======================================================================
-// Variable types:
-typedef unsigned int COUNTER;
-typedef unsigned int NODE;
-typedef std::vector<NODE> NODES; // list of nodes
-typedef std::vector<bool> BOOLS;
-struct CONTACT {NODE i; NODE j;}; // contact (i,j)
-typedef std::vector<CONTACT> CONTACTS; // contacts in a single time-frame
-typedef std::vector<CONTACTS> CONTACTS_LIST; // list of contact lists
-typedef std::vector<double> CHARACTERISTICS; // characteristics of nodes, e.g., susceptibilities
-// Random number generators:
-typedef boost::mt19937_64 ENG; // use Mersenne Twister 19937 as PRNG engine
-typedef boost::uniform_int<> DIST_INT; // define uniform distribution of integers
-typedef boost::uniform_real<> DIST_REAL; // define uniform distribution of reals on [0,1)
-typedef boost::exponential_distribution<> DIST_EXP; // define exponential distribution
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <NetworkFiles.h>
+#include <TemporalGillespie.h>
 
 //======================================================================
 // Global parameters
@@ -70,89 +50,37 @@ typedef boost::exponential_distribution<> DIST_EXP; // define exponential distri
 COUNTER N; //number of nodes in network
 COUNTER T_data; //length of dataset (time steps)
 COUNTER dt; //input time resolution (integer)
-CHARACTERISTICS susceptibilities;
-CHARACTERISTICS infectivities;
-CHARACTERISTICS recoverabilities;
 char inputname[200], outputname[200];
-// Input/Output streams:
+// Output stream:
 std::ofstream output;
-std::ifstream input;
-// Initialize PRNG:
-ENG eng(9071982);
-DIST_INT dist_int;
-DIST_REAL dist_rand(0,1);
-DIST_EXP dist_exp;
 
 //======================================================================
-// Function for importing list of contacts from tij format file:
+// Function for importing the temporal network from a tij or binary file:
 //======================================================================
-CONTACTS_LIST loadContactListList(char *inputname)
+TemporalNetwork loadTemporalNetwork(char *inputname)
 {
-    // Timer:
-    std::clock_t clockStart = std::clock();
-
-    // Define list of contact lists and list of nodes, etc.:
-    std::string line;
-    COUNTER t;
-    NODE i,j;
-    NODES nodes;
-    CONTACTS_LIST contactListList;
-    CONTACTS contactList;
-    CONTACT contact;
-    NODES::iterator last;
-
     // Print name of input file to screen:
     std::cout << "Filename: " << inputname << std::endl;
 
-    input.open(inputname);
-    // If input-file is not found or cannot be read, raise error and exit:
-    if(input==NULL){ std::cout << "ERROR! File cannot be read."; return contactListList; }
-
-    // Create list of nodes in file:
-    while(getline(input,line))
+    // Map a binary file, or parse a tij file (in parallel) and number the nodes 0,...,N-1:
+    NetworkFile file;
+    try
     {
-        input>>t>>i>>j;
-        nodes.push_back(i);
-        nodes.push_back(j);
+        file=open_network(inputname,dt);
     }
-    T_data=t+1; std::cout << "T=" << T_data << std::endl;
-    input.close();
-    // Sort list and remove duplicates:
-    std::sort(nodes.begin(),nodes.end());
-    last=unique(nodes.begin(),nodes.end());
-    nodes.resize(distance(nodes.begin(),last));
-    N=nodes.size(); //number of unique nodes (network size)
-    // List for redefining node IDs:
-    NODES nodeIDs(nodes[nodes.size()-1]+1);
-    std::cout << std::endl;
-    for(int n=0; n<N; n++)
+    catch(std::exception &error)
     {
-        nodeIDs[nodes[n]]=n;
-    }
-
-    // Read first line of inputfile as list of characters and get t,i,j:
-    input.open(inputname);
-    getline(input,line);
-    input>>t>>i>>j;
-    // Loop over t<T and create list of contact lists:
-    for(COUNTER tt=0; tt<T_data; tt+=dt)
-    {
-        while(t==tt && !input.eof())
-        {
-            contact.i=nodeIDs[i]; contact.j=nodeIDs[j];
-            contactList.push_back(contact);
-            // Read line and get t,i,j:
-            getline(input,line);
-            input>>t>>i>>j;
-        }
-        contactListList.push_back(contactList);
-        contactList.clear();
+        // If input-file is not found or cannot be read, raise error and exit:
+        std::cout << "ERROR! " << error.what() << std::endl;
+        return TemporalNetwork();
     }
-    input.close();
+    T_data=file.T_data; //length of dataset
+    N=file.network.number_of_nodes(); //number of unique nodes (network size)
+    std::cout << "T=" << T_data << std::endl;
 
-    std::cout << std::endl << N << " nodes. Construction time: " << ( clock() - clockStart ) / (double) CLOCKS_PER_SEC << " s\n\n";
+    std::cout << std::endl << N << " nodes. Construction time: " << file.load_time << " s (" << file.megabytes_per_second() << " MB/s)\n\n";
 
-    return contactListList;
+    return std::move(file.network);
 }
 
 //======================================================================
@@ -193,215 +121,57 @@ int main(int argc, char *argv[])
     COUNTER T_simulation = atoi(argv[5]); //simulation time
     COUNTER ensembleSize = atoi(argv[6]); //ensemble size (number of realizations)
     COUNTER outputTimeResolution = atoi(argv[7]); //output time-resolution
+    std::string sampler = argc>8 ? argv[8] : "sum_tree"; //sampler of the heterogeneous rates
 
-    // Open input file and load contact_lists:
+    // Open input file and load the temporal network:
     sprintf(inputname,"%s",datafile);
-    CONTACTS_LIST contactListList=loadContactListList(inputname);
-    // Check if length of contacts_list > 0 and end program if it is not:
-    if(contactListList.size()==0){ std::cout << "Error! Dataset empty.\n"; return 0; }
-
-    //-------------------------------------------------------------------------------------
-    // Define variables:
-    //-------------------------------------------------------------------------------------
-    NODES infected; //list of infected nodes
-    CHARACTERISTICS mus; //list of cumulative sums of their recovery rates
-    double Mu; //total recovery rate
-    BOOLS isInfected; //list which nodes are susceptible/infected, respectively
-    COUNTER I; //number of infected and recovered nodes
-    COUNTER SI; //number of susceptible nodes in contact with infectious nodes
-    NODES si_s; //list of susceptible nodes in contact with infected nodes
-    CHARACTERISTICS betas; //list of cumulative sums of their infection rates
-    double Beta; //total infection rate
-    double Lambda; //total transition rate
-    double xi;
-    COUNTER t; //time counter
-    COUNTER t_infectionStart; //starting time of infection
-    NODE root; //root node of infection
-    double tau; //renormalized waiting time until next event
-    NODE i,j;
-    CONTACTS_LIST::iterator contact_iterator; //iterator over list of contacts
-    CONTACTS::iterator contactList_iterator; //iterator over contacts
-    double r_transition; //random variable for choosing which transition happens
-    CHARACTERISTICS::iterator r_weightedSampling; //iterator for drawing the transition
-    COUNTER m; //number of this transition
-    COUNTER n; //time counter
-    double lambda_draw; //rate of drawn transition
-    double lambda_m_new;
-    CHARACTERISTICS::iterator mu_iterator; //iterator over list of recovery rates
-    NODES::iterator node_iterator; //iterator over list of nodes
-    NODES::iterator last; //iterator for use when generating unique list of new infected nodes
-    // Containers for output data:
-    NODES sumI_t(T_simulation/outputTimeResolution); //list of number of infected nodes in each recorded frame
-    NODES hist_I(N+1); //histogram of I values at end of simulations
-    // Random number generators:
-    boost::variate_generator<ENG,DIST_INT> randint(eng,dist_int); //random integer
-    boost::variate_generator<ENG,DIST_REAL> rand(eng,dist_rand); //random float on [0,1[
-    boost::variate_generator<ENG,DIST_EXP> randexp(eng,dist_exp); //random exponentially distributed float
-    // Assign individual values of population:
-    recoverabilities.assign(N,1.);
-    susceptibilities.assign(N,1.);
-    infectivities.assign(N,1.);
+    const TemporalNetwork network=loadTemporalNetwork(inputname);
+    // Check if the network has any time-frames and end program if it does not:
+    if(network.number_of_slices()==0){ std::cout << "Error! Dataset empty.\n"; return 0; }
 
     //-------------------------------------------------------------------------------------
     // Simulate:
     //-------------------------------------------------------------------------------------
     std::clock_t clockStart = std::clock();     //timer
-    COUNTER stopped=0; //counter of number of simulations that stopped (I=0) during T_simulation
-    for(int q=0; q<ensembleSize; q++)
+    SimulationParameters parameters;
+    parameters.T_simulation = T_simulation;
+    parameters.output_time_resolution = outputTimeResolution;
+    parameters.number_of_simulations = ensembleSize;
+    parameters.seed = 9071982;
+    parameters.random_t_infection_start = true; //random root node and random starting time of infection
+    parameters.verbose = true;
+    // Assign individual values of population:
+    std::vector<double> susceptibilities(N,1.);
+    std::vector<double> infectivities(N,1.);
+    std::vector<double> recoverabilities(N,1.);
+    EnsembleResult result;
+    try
     {
-        std::cout << q << "/" << ensembleSize << std::endl; //print realization # to screen
-        // Choose at random infectious root node and run SIR process starting from root:
-        root=randint(N);
-        // Clear parameters:
-        infected.clear();
-        // Initialize lists of infected nodes and infected node IDs:
-        infected.push_back(root);
-        I=1;
-        mus.assign(1,0.);
-        mus.push_back(mu*recoverabilities[root]);
-        Mu=mus.back();
-        isInfected.assign(N,false);
-        isInfected[root]=true;
-       // First waiting time:
-        tau=randexp(1);
-        // random starting time of infection:
-        t_infectionStart=randint(T_data);
-        // set simulation time to zero:
-        t=0;
-
-        //--- Loop over list of contact lists: ---
-        while(I>0 && t<T_simulation) //loop until either I=0 or t>=T_simulation
+        result = with_sampler(sampler, [&](auto weighted_sampler)
         {
-            for(contact_iterator=contactListList.begin()+t_infectionStart; contact_iterator!=contactListList.end(); contact_iterator++)
-            {
-                // Create list of susceptible nodes in contact with infected nodes:
-                si_s.clear();
-                betas.assign(1,0.);
-                for(contactList_iterator=(*contact_iterator).begin(); contactList_iterator!=(*contact_iterator).end(); contactList_iterator++)
-                {
-                    i=(*contactList_iterator).i;
-                    j=(*contactList_iterator).j;
-                    if(isInfected[i])
-                    {
-                        if(!isInfected[j])
-                        {
-                            si_s.push_back(j);
-                            betas.push_back(beta*susceptibilities[j]*infectivities[i]+betas.back());
-                        }
-                    }
-                    else
-                    {
-                        if(isInfected[j])
-                        {
-                            si_s.push_back(i);
-                            betas.push_back(beta*susceptibilities[i]*infectivities[j]+betas.back());
-                        }
-                    }
-                }
-                SI=si_s.size();
-                Beta=betas.back();
-                Lambda=Beta+Mu;
+            typedef HeterogeneousRates < decltype(weighted_sampler) > RATES;
+            TemporalGillespie < SIS, RATES > engine(network, beta, ExponentialRecovery(mu), RATES(susceptibilities,infectivities,recoverabilities));
+            return run_ensemble(engine, parameters);
+        });
+    }
+    catch(const std::invalid_argument &error){ std::cout << "Error! " << error.what() << "\n"; return 0; }
+    COUNTER stopped = result.number_stopped; //counter of number of simulations that stopped (I=0) during T_simulation
 
-                // Check if transition takes place during time-step:
-                if(tau>=Lambda) //no transition takes place
-                {
-                    tau-=Lambda;
-                }
-                else //at least one transition takes place
-                {
-                    xi=1.;
-                    // Sampling step:
-                    while(tau<xi*Lambda) //repeat if next tau is smaller than ~ Lambda-tau
-                    {
-                        xi-=tau/Lambda;
-                        r_transition=Lambda*rand(); //random variable for weighted sampling of transitions
-                        if(r_transition<Beta) //S->I
-                        {
-                            r_weightedSampling=std::upper_bound(betas.begin(),betas.end(),r_transition)-1; //find beta^(m) interval corresponding to x_choice
-                            m=r_weightedSampling-betas.begin(); //corresponding m
-                            // Add infected node to lists:
-                            isInfected[si_s[m]]=true;
-                            infected.push_back(si_s[m]);
-                            mus.push_back(mu*recoverabilities[si_s[m]]+mus.back());
-                            Mu=mus.back();
-                        }
-                        else //I->S
-                        {
-                            r_weightedSampling=std::upper_bound(mus.begin(),mus.end(),r_transition-Beta)-1; //find mu^(m) interval corresponding to x_choice
-                            m=r_weightedSampling-mus.begin(); //corresponding m
-                            lambda_draw=mu*recoverabilities[infected[m]]; //extract rate for transition m
-                            isInfected[infected[m]]=false;
-                            infected[m]=infected.back(); //remove drawn element from infected
-                            infected.pop_back();
-                            lambda_m_new=mu*recoverabilities[infected[m]];
-                            r_weightedSampling=r_weightedSampling-1+lambda_m_new; //replace mus[m]
-                            mus.pop_back();
-                            // Subtract lambda_draw from and add lambda_m_new to all mus[n] for n>m
-                            for(mu_iterator=r_weightedSampling+1; mu_iterator!=mus.end(); mu_iterator++) *mu_iterator+=lambda_m_new-lambda_draw;
-                            Mu=mus.back();
-                        }
-                        // Redo list of susceptible nodes in contact with infected nodes to update betas:
-                        si_s.clear();
-                        betas.assign(1,0.);
-                        for(contactList_iterator=(*contact_iterator).begin(); contactList_iterator!=(*contact_iterator).end(); contactList_iterator++)
-                        {
-                            i=(*contactList_iterator).i;
-                            j=(*contactList_iterator).j;
-                            if(isInfected[i])
-                            {
-                                if(!isInfected[j])
-                                {
-                                    si_s.push_back(j);
-                                    betas.push_back(beta*susceptibilities[j]*infectivities[i]+betas.back());
-                                }
-                            }
-                            else
-                            {
-                                if(isInfected[j])
-                                {
-                                    si_s.push_back(i);
-                                    betas.push_back(beta*susceptibilities[i]*infectivities[j]+betas.back());
-                                }
-                            }
-                        }
-                        SI=si_s.size();
-                        Beta=betas.back();
-                        Lambda=Beta+Mu; //new cumulative transition rate
-                        // Draw new renormalized waiting time:
-                        tau=randexp(1);
-                    }
-                    // Update list of number of infected nodes:
-                    I=infected.size();
-                }
-                // Stop if I=0:
-                if(I==0)
-                {
-                    stopped++;
-                    break;
-                }
-                // read out I and R if t is divisible by outputTimeResolution
-                if(t % outputTimeResolution ==0)
-                {
-                    if(t>=T_simulation)
-                    {
-                        break;
-                    }
-                    else
-                    {
-                        sumI_t[t/outputTimeResolution]+=I;
-                    }
-                }
-                t++;
-            }
-            t_infectionStart=0;
-        }
-        hist_I[I]++;
+    // Containers for output data:
+    NODES::iterator node_iterator; //iterator over list of nodes
+    NODES sumI_t(T_simulation/outputTimeResolution); //list of number of infected nodes in each recorded frame
+    NODES hist_I(N+1); //histogram of I values at end of simulations
+    for(COUNTER q=0; q<ensembleSize; q++)
+    {
+        for(COUNTER n=0; n<sumI_t.size(); n++)
+            sumI_t[n]+=result.I(q,n);
+        hist_I[result.final_I[q]]++;
     }
+    double t_simu = ( std::clock() - clockStart ) / (double) CLOCKS_PER_SEC;
 
     //-------------------------------------------------------------------------------------
     // Save epidemic data to disk:
     //-------------------------------------------------------------------------------------
-    double t_simu = ( std::clock() - clockStart ) / (double) CLOCKS_PER_SEC;
 
     clockStart=std::clock();
     // Open output file:
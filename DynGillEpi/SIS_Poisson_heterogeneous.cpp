@@ -0,0 +1,83 @@
+/* Simulates independent realizations of a heterogeneous SIS process on
+a temporal network. The nodes of the network may have different
+susceptibility, infectivity, and recoverability, i.e., the infection
+rate along an SI contact is
+    infection_rate_per_dt * susceptibilities[S] * infectivities[I]
+and the recovery rate of an infected node is
+    recovery_rate_per_dt * recoverabilities[I].
+An empty list means a factor of 1 for every node.*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+#include "SIS_Poisson_heterogeneous.h"
+
+using namespace std;
+
+//======================================================================
+// Main:
+//======================================================================
+SI_result
+    SIS_Poisson_heterogeneous(const TemporalNetwork &network,
+                              double infection_rate_per_dt,
+                              double recovery_rate_per_dt,
+                              const vector < double > &susceptibilities,
+                              const vector < double > &infectivities,
+                              const vector < double > &recoverabilities,
+                              size_t T_simulation,
+                              size_t output_time_resolution,
+                              size_t number_of_simulations,
+                              size_t initial_number_of_infected,
+                              size_t seed,
+                              size_t t_infection_start,
+                              bool verbose,
+                              size_t n_threads,
+                              bool store_realizations,
+                              const vector < double > &quantiles,
+                              bool record_events,
+                              size_t record_every,
+                              double record_min_interval,
+                              const string &sampler,
+                              const atomic < bool > *cancel
+            )
+{
+    size_t N = network.number_of_nodes();
+    SimulationParameters parameters = simulation_parameters(T_simulation,
+                                                            output_time_resolution,
+                                                            number_of_simulations,
+                                                            initial_number_of_infected,
+                                                            seed,
+                                                            t_infection_start,
+                                                            verbose,
+                                                            n_threads,
+                                                            store_realizations,
+                                                            quantiles,
+                                                            record_events,
+                                                            record_every,
+                                                            record_min_interval
+                                                           );
+
+    //-------------------------------------------------------------------------------------
+    // Simulate:
+    //-------------------------------------------------------------------------------------
+    return with_sampler(sampler, [&](auto weighted_sampler)
+    {
+        typedef HeterogeneousRates < decltype(weighted_sampler) > RATES;
+        TemporalGillespie < SIS, RATES > engine(network,
+                                                 infection_rate_per_dt,
+                                                 ExponentialRecovery(recovery_rate_per_dt),
+                                                 RATES::for_nodes(N,susceptibilities,infectivities,recoverabilities)
+                                                );
+        EnsembleResult ensemble = run_ensemble(engine, parameters, cancel);
+
+        if (verbose)
+        {
+            std::cout << std::endl << "temporal Gillespie---heterogeneous & Poissonian SIS: N=" << N << ", beta=" << infection_rate_per_dt << ", mu=" << recovery_rate_per_dt << ", resolution = " << output_time_resolution << std::endl;
+            std::cout << "Simulation time: " << ensemble.simulation_time << ", Stopped: " << ensemble.number_stopped << "/" << number_of_simulations << ", " << ensemble.threads << std::endl;
+        }
+
+        return as_SI_result(ensemble);
+    });
+}
@@ -0,0 +1,30 @@
+#ifndef __SIS_POISS_HET_H__
+#define __SIS_POISS_HET_H__
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+
+SI_result
+    SIS_Poisson_heterogeneous(const TemporalNetwork &network,
+                              double infection_rate_per_dt,
+                              double recovery_rate_per_dt,
+                              const vector < double > &susceptibilities,
+                              const vector < double > &infectivities,
+                              const vector < double > &recoverabilities,
+                              size_t T_simulation,
+                              size_t output_time_resolution,
+                              size_t number_of_simulations = 1,
+                              size_t initial_number_of_infected = 1,
+                              size_t seed = 0,
+                              size_t t_infection_start = 0,
+                              bool verbose = false,
+                              size_t n_threads = 1,
+                              bool store_realizations = true,
+                              const vector < double > &quantiles = vector < double >(),
+                              bool record_events = false,
+                              size_t record_every = 1,
+                              double record_min_interval = 0.,
+                              const string &sampler = "sum_tree",
+                              const atomic < bool > *cancel = nullptr
+            );
+
+#endif
@@ -1,10 +1,10 @@
 #ifndef __SIS_POISS_HOMO_H__
 #define __SIS_POISS_HOMO_H__
 #include <Utilities.h>
+#include <TemporalNetwork.h>
 
 SI_result
-    SIS_Poisson_homogeneous(size_t N,
-                            CONTACTS_LIST contactListList,
+    SIS_Poisson_homogeneous(const TemporalNetwork &network,
                             double infection_rate_per_dt,
                             double recovery_rate_per_dt,
                             size_t T_simulation,
@@ -13,7 +13,32 @@ SI_result
                             size_t initial_number_of_infected = 1,
                             size_t seed = 0,
                             size_t t_infection_start = 0,
-                            bool verbose = false
+                            bool verbose = false,
+                            size_t n_threads = 1,
+                            bool store_realizations = true,
+                            const vector < double > &quantiles = vector < double >(),
+                            bool record_events = false,
+                            size_t record_every = 1,
+                            double record_min_interval = 0.,
+                            const atomic < bool > *cancel = nullptr
+            );
+
+// Runs number_of_simulations realizations at every point
+// (infection_rates_per_dt[p], recovery_rates_per_dt[p],
+// initial_numbers_of_infected[p]) of a parameter grid on n_threads
+// threads, see run_sweep. A list of length one is used for all points.
+vector < SweepPoint >
+    SIS_Poisson_homogeneous_sweep(const TemporalNetwork &network,
+                                  const vector < double > &infection_rates_per_dt,
+                                  const vector < double > &recovery_rates_per_dt,
+                                  size_t T_simulation,
+                                  size_t number_of_simulations = 1,
+                                  const vector < size_t > &initial_numbers_of_infected = vector < size_t >(1, 1),
+                                  size_t seed = 0,
+                                  size_t t_infection_start = 0,
+                                  bool verbose = false,
+                                  size_t n_threads = 1,
+                                  const atomic < bool > *cancel = nullptr
             );
 
 #endif
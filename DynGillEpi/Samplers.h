@@ -0,0 +1,401 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __SAMPLERS_H__
+#define __SAMPLERS_H__
+
+#include <Utilities.h>
+
+using namespace std;
+
+//======================================================================
+// Samplers of transitions
+//======================================================================
+// A sampler holds a set of keys 0 <= key < capacity, each with a
+// non-negative weight, and draws a key with probability proportional to
+// its weight. All samplers have the interface
+//
+//     void reset(size_t capacity);          // empty set of given capacity
+//     void clear();                         // remove all keys
+//     void insert(size_t key, double w);    // add key or change its weight
+//     void erase(size_t key);               // remove key (if present)
+//     bool contains(size_t key) const;
+//     size_t size() const;                  // number of keys
+//     double total() const;                 // sum of weights
+//     size_t sample(ENG &generator);        // draw a key
+//
+// and iteration over the keys in the set.
+
+//----------------------------------------------------------------------
+// All keys have the same weight: O(1) for every operation
+//----------------------------------------------------------------------
+class UniformSampler {
+    public:
+        UniformSampler() : unit(0.0) {}
+
+        void reset(size_t capacity) { keys.reset(capacity); }
+        void clear() { keys.clear(); }
+        void insert(size_t key, double w) { unit = w; keys.insert(key); }
+        void erase(size_t key) { keys.erase(key); }
+        bool contains(size_t key) const { return keys.contains(key); }
+        size_t size() const { return keys.size(); }
+        double total() const { return unit*keys.size(); }
+        vector<size_t>::const_iterator begin() const { return keys.begin(); }
+        vector<size_t>::const_iterator end() const { return keys.end(); }
+
+        size_t sample(ENG &generator)
+        {
+            return keys[(size_t) (keys.size() * rand(generator))];
+        }
+
+    private:
+        IndexedSet keys;
+        double unit;
+        DIST_REAL rand{0.0,1.0};
+};
+
+//----------------------------------------------------------------------
+// List of cumulative sums of the weights, in order of insertion. Drawing
+// is a binary search, O(log n), but changing or removing a weight shifts
+// all cumulative sums after it, O(n).
+//----------------------------------------------------------------------
+class CumulativeSampler {
+    public:
+        void reset(size_t capacity)
+        {
+            keys.reset(capacity);
+            cumulative.assign(1,0.0);
+        }
+
+        void clear()
+        {
+            keys.clear();
+            cumulative.assign(1,0.0);
+        }
+
+        void insert(size_t key, double w)
+        {
+            if (keys.contains(key))
+            {
+                size_t m = position(key);
+                shift(m+1, w - weight_at(m));
+                return;
+            }
+            keys.insert(key);
+            cumulative.push_back(cumulative.back() + w);
+        }
+
+        void erase(size_t key)
+        {
+            if (!keys.contains(key))
+                return;
+            // the set moves its last key into the freed slot, do the same
+            // with the weights
+            size_t m = position(key);
+            size_t last = keys.size()-1;
+            double w_removed = weight_at(m);
+            double w_moved = weight_at(last);
+            keys.erase(key);
+            cumulative.pop_back();
+            if (m < last)
+                shift(m+1, w_moved - w_removed);
+            if (keys.size() == 0)
+                cumulative.assign(1,0.0);
+        }
+
+        bool contains(size_t key) const { return keys.contains(key); }
+        size_t size() const { return keys.size(); }
+        double total() const { return cumulative.back(); }
+        vector<size_t>::const_iterator begin() const { return keys.begin(); }
+        vector<size_t>::const_iterator end() const { return keys.end(); }
+
+        size_t sample(ENG &generator)
+        {
+            double r = total() * rand(generator);
+            size_t m = upper_bound(cumulative.begin(),cumulative.end(),r) - cumulative.begin() - 1;
+            return keys[min(m, keys.size()-1)];
+        }
+
+    private:
+        // index of key in the order of the set (and of cumulative)
+        size_t position(size_t key) const
+        {
+            return find(keys.begin(),keys.end(),key) - keys.begin();
+        }
+
+        double weight_at(size_t m) const { return cumulative[m+1] - cumulative[m]; }
+
+        void shift(size_t first, double delta)
+        {
+            for(size_t m = first; m < cumulative.size(); ++m)
+                cumulative[m] += delta;
+        }
+
+        IndexedSet keys;
+        vector < double > cumulative; // cumulative[m+1] = sum of the weights of keys[0..m]
+        DIST_REAL rand{0.0,1.0};
+};
+
+//----------------------------------------------------------------------
+// Complete binary tree over all possible keys, every inner node holds the
+// sum of the weights below it. Inserting, changing and removing a weight
+// and drawing a key are O(log capacity). An inner node is recomputed from
+// its children rather than incremented, such that rounding errors do not
+// pile up over a long realization.
+//----------------------------------------------------------------------
+class SumTreeSampler {
+    public:
+        SumTreeSampler() : leaves(1) {}
+
+        void reset(size_t capacity)
+        {
+            keys.reset(capacity);
+            leaves = 1;
+            while (leaves < capacity)
+                leaves *= 2;
+            tree.assign(2*leaves,0.0);
+        }
+
+        void clear()
+        {
+            // all keys go, so every node on a path from a key to the root
+            // becomes 0; a path can stop at the first node already cleared
+            for(auto const &key: keys)
+                for(size_t i = leaves + key; i > 0 && tree[i] != 0.0; i /= 2)
+                    tree[i] = 0.0;
+            keys.clear();
+        }
+
+        void insert(size_t key, double w)
+        {
+            keys.insert(key);
+            set(key, w);
+        }
+
+        void erase(size_t key)
+        {
+            if (!keys.contains(key))
+                return;
+            keys.erase(key);
+            set(key, 0.0);
+        }
+
+        bool contains(size_t key) const { return keys.contains(key); }
+        size_t size() const { return keys.size(); }
+        double total() const { return tree[1]; }
+        vector<size_t>::const_iterator begin() const { return keys.begin(); }
+        vector<size_t>::const_iterator end() const { return keys.end(); }
+
+        size_t sample(ENG &generator)
+        {
+            double r = total() * rand(generator);
+            size_t i = 1;
+            while (i < leaves)
+            {
+                i *= 2;
+                // never descend into an empty subtree, r may be off by
+                // rounding errors
+                if (tree[i+1] > 0.0 && (r >= tree[i] || tree[i] <= 0.0))
+                {
+                    r -= tree[i];
+                    i++;
+                }
+            }
+            return i - leaves;
+        }
+
+    private:
+        void set(size_t key, double w)
+        {
+            size_t i = leaves + key;
+            tree[i] = w;
+            for(i /= 2; i > 0; i /= 2)
+                tree[i] = tree[2*i] + tree[2*i+1];
+        }
+
+        IndexedSet keys;
+        size_t leaves; // number of leaves, a power of two >= capacity
+        vector < double > tree; // tree[1] is the root, the children of i are 2i and 2i+1, key k is leaf leaves+k
+        DIST_REAL rand{0.0,1.0};
+};
+
+//----------------------------------------------------------------------
+// Composition and rejection: the keys are grouped by weight, group g
+// holding the weights in [2^(g-1), 2^g). Drawing picks a group by a
+// linear search over the non-empty groups and then a key of the group
+// uniformly, accepted with probability weight/2^g >= 1/2. Inserting,
+// changing and removing a weight are O(1), drawing is O(number of
+// groups), which is small if the weights span a few orders of magnitude
+// only. Keys of weight 0 are in the set but in no group.
+//----------------------------------------------------------------------
+class CompositionRejectionSampler {
+    public:
+        CompositionRejectionSampler() : sum(0.0) {}
+
+        void reset(size_t capacity)
+        {
+            empty_groups();
+            keys.reset(capacity);
+            weights.assign(capacity,0.0);
+            group_of.assign(capacity,(size_t) NO_GROUP);
+            position.assign(capacity,0);
+            groups.resize(NUMBER_OF_GROUPS);
+            occupied.reset(NUMBER_OF_GROUPS);
+        }
+
+        void clear()
+        {
+            empty_groups();
+            keys.clear();
+        }
+
+        void insert(size_t key, double w)
+        {
+            keys.insert(key);
+            remove_from_group(key);
+            add_to_group(key, w);
+        }
+
+        void erase(size_t key)
+        {
+            if (!keys.contains(key))
+                return;
+            remove_from_group(key);
+            keys.erase(key);
+        }
+
+        bool contains(size_t key) const { return keys.contains(key); }
+        size_t size() const { return keys.size(); }
+        double total() const { return sum; }
+        vector<size_t>::const_iterator begin() const { return keys.begin(); }
+        vector<size_t>::const_iterator end() const { return keys.end(); }
+
+        size_t sample(ENG &generator)
+        {
+            // composition: group with probability proportional to its sum
+            double r = sum * rand(generator);
+            size_t g = occupied[occupied.size()-1];
+            for(auto const &h: occupied)
+            {
+                if (r < groups[h].sum)
+                {
+                    g = h;
+                    break;
+                }
+                r -= groups[h].sum;
+            }
+
+            // rejection: uniform member, accepted with weight/upper bound
+            const vector < size_t > &members = groups[g].members;
+            double bound = upper_bound_of(g);
+            while (true)
+            {
+                size_t key = members[(size_t) (members.size() * rand(generator))];
+                if (rand(generator) * bound < weights[key])
+                    return key;
+            }
+        }
+
+    private:
+        static const size_t NO_GROUP = (size_t) -1;
+        // frexp gives exponents in [DBL_MIN_EXP-DBL_MANT_DIG+1, DBL_MAX_EXP]
+        static const int MIN_EXPONENT = -1100;
+        static const size_t NUMBER_OF_GROUPS = 2200;
+
+        struct GROUP {
+            vector < size_t > members;
+            double sum = 0.0;
+        };
+
+        static double upper_bound_of(size_t g) { return ldexp(1.0, (int) g + MIN_EXPONENT); }
+
+        // take every key out of its group, keeping the keys in the set
+        void empty_groups()
+        {
+            for(auto const &g: occupied)
+            {
+                groups[g].members.clear();
+                groups[g].sum = 0.0;
+            }
+            occupied.clear();
+            for(auto const &key: keys)
+                group_of[key] = NO_GROUP;
+            sum = 0.0;
+        }
+
+        void add_to_group(size_t key, double w)
+        {
+            weights[key] = w;
+            if (w <= 0.0)
+                return;
+            int exponent;
+            frexp(w, &exponent);
+            size_t g = (size_t) (exponent - MIN_EXPONENT);
+            group_of[key] = g;
+            position[key] = groups[g].members.size();
+            groups[g].members.push_back(key);
+            groups[g].sum += w;
+            occupied.insert(g);
+            sum += w;
+        }
+
+        void remove_from_group(size_t key)
+        {
+            size_t g = group_of[key];
+            if (g == NO_GROUP)
+                return;
+            vector < size_t > &members = groups[g].members;
+            members[position[key]] = members.back();
+            position[members.back()] = position[key];
+            members.pop_back();
+            group_of[key] = NO_GROUP;
+            if (members.empty())
+            {
+                // start from an exact 0 to not carry rounding errors along,
+                // and sum up the other groups anew, such that the error of
+                // a group of large weights does not stay in the total
+                groups[g].sum = 0.0;
+                occupied.erase(g);
+                sum = 0.0;
+                for(auto const &h: occupied)
+                    sum += groups[h].sum;
+            }
+            else
+            {
+                groups[g].sum -= weights[key];
+                sum -= weights[key];
+            }
+        }
+
+        IndexedSet keys;
+        vector < double > weights; // weight per key
+        vector < size_t > group_of; // group per key, NO_GROUP if absent or of weight 0
+        vector < size_t > position; // index of a key in the members of its group
+        vector < GROUP > groups;
+        IndexedSet occupied; // indices of the non-empty groups
+        double sum; // sum of all weights
+        DIST_REAL rand{0.0,1.0};
+};
+
+#endif
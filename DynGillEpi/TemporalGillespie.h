@@ -0,0 +1,1722 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __TEMPORAL_GILLESPIE_H__
+#define __TEMPORAL_GILLESPIE_H__
+
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <Samplers.h>
+#include <RecoveryDistributions.h>
+#include <EnsembleStatistics.h>
+#include <type_traits>
+#include <queue>
+#include <chrono>
+#include <mutex>
+
+using namespace std;
+
+//======================================================================
+// Temporal Gillespie algorithm
+//======================================================================
+// One engine for all variants of the simulation, put together from
+// policies at compile time:
+//
+//     TemporalGillespie < MODEL, RATES, PRUNING, RECOVERY, NETWORK >
+//
+// MODEL    - SIS or SIR, what a node becomes when it recovers
+// RATES    - HomogeneousRates or HeterogeneousRates<>, per-node factors
+//            of the infection and recovery rates
+// PRUNING  - NoPruning or ContactRemoval, whether contacts that can not
+//            transmit anymore are dropped for the rest of a realization
+// RECOVERY - the distribution of the recovery times, ExponentialRecovery
+//            or any of RecoveryDistributions.h
+// NETWORK  - TemporalNetwork, held in memory, or StreamedNetwork, read
+//            from disk while the simulation runs (not with ContactRemoval)
+//
+// e.g. TemporalGillespie < SIR, HomogeneousRates, NoPruning, WeibullRecovery >
+// is the non-Markovian SIR process.
+
+//----------------------------------------------------------------------
+// Compartment models
+//----------------------------------------------------------------------
+struct SIS { static const bool immunity = false; }; // recovered nodes are susceptible again
+struct SIR { static const bool immunity = true; }; // recovered nodes are immune
+
+//----------------------------------------------------------------------
+// Rate policies
+//----------------------------------------------------------------------
+// All nodes are alike, such that every transition of a kind has the same
+// rate and is drawn uniformly.
+struct HomogeneousRates {
+    static const bool uniform = true;
+    typedef SumTreeSampler WEIGHTED_SAMPLER; // for recovery rates that change in time
+
+    double susceptibility(NODE) const { return 1.0; }
+    double infectivity(NODE) const { return 1.0; }
+    double recoverability(NODE) const { return 1.0; }
+};
+
+// The rate of infection along an SI contact is beta*susceptibilities[S]*
+// infectivities[I], the rate of recovery is mu*recoverabilities[I].
+// SAMPLER draws the transitions according to their rates (see Samplers.h).
+template < typename SAMPLER = SumTreeSampler >
+struct HeterogeneousRates {
+    static const bool uniform = false;
+    typedef SAMPLER WEIGHTED_SAMPLER;
+
+    HeterogeneousRates() {}
+    HeterogeneousRates(const vector < double > &susceptibilities,
+                       const vector < double > &infectivities,
+                       const vector < double > &recoverabilities
+                      )
+        : susceptibilities(susceptibilities),
+          infectivities(infectivities),
+          recoverabilities(recoverabilities)
+    {}
+
+    // Rates for a network of N nodes, an empty list means a factor of 1
+    // for every node. Throws invalid_argument if a list is not of size N.
+    static HeterogeneousRates for_nodes(size_t N,
+                                        vector < double > susceptibilities,
+                                        vector < double > infectivities,
+                                        vector < double > recoverabilities
+                                       )
+    {
+        for(auto *factors: { &susceptibilities, &infectivities, &recoverabilities })
+        {
+            if (factors->empty())
+                factors->assign(N,1.);
+            else if (factors->size() != N)
+                throw invalid_argument("susceptibilities, infectivities and recoverabilities have to be empty or of size N");
+        }
+        return HeterogeneousRates(susceptibilities, infectivities, recoverabilities);
+    }
+
+    double susceptibility(NODE n) const { return susceptibilities[n]; }
+    double infectivity(NODE n) const { return infectivities[n]; }
+    double recoverability(NODE n) const { return recoverabilities[n]; }
+
+    vector < double > susceptibilities;
+    vector < double > infectivities;
+    vector < double > recoverabilities;
+};
+
+// Calls f with a default-constructed sampler of the given name, such that
+// the sampler of the heterogeneous rates can be chosen at run time:
+//     "sum_tree"              - SumTreeSampler, O(log n) for everything
+//     "composition_rejection" - CompositionRejectionSampler, O(1) updates,
+//                               fastest if the rates span a few orders of
+//                               magnitude only
+//     "cumulative"            - CumulativeSampler, O(n) updates
+// Throws invalid_argument for any other name.
+template < typename F >
+auto with_sampler(const string &name, F f) -> decltype(f(SumTreeSampler()))
+{
+    if (name == "sum_tree")
+        return f(SumTreeSampler());
+    else if (name == "composition_rejection")
+        return f(CompositionRejectionSampler());
+    else if (name == "cumulative")
+        return f(CumulativeSampler());
+    throw invalid_argument("Unknown sampler '" + name + "', use 'sum_tree', 'composition_rejection' or 'cumulative'");
+}
+
+//----------------------------------------------------------------------
+// Pruning policies
+//----------------------------------------------------------------------
+// Every contact of a slice is considered in every pass. The SI contacts
+// are picked out by find_si_contacts, from the contacts of the infected
+// nodes while those are few (see scan_from_infected), from all contacts
+// otherwise.
+struct NoPruning {
+    template < typename NETWORK >
+    void reset(const NETWORK &network)
+    {
+        N = network.number_of_nodes();
+        si.resize(network.max_contacts_per_slice());
+    }
+
+    // calls f(e) for the SI contacts e of the slice, in increasing order
+    template < typename F >
+    void for_each_si_contact(size_t, const TemporalNetwork::Slice &slice, const STATES &state, const IndexedSet &infected, F f)
+    {
+        size_t count = scan_from_infected(infected.size(), slice.size(), N) ?
+                       find_si_contacts(slice, infected, state.data(), si.data()) :
+                       find_si_contacts(slice.begin(), slice.size(), state.data(), si.data());
+        for(size_t k = 0; k < count; ++k)
+            f(si[k]);
+    }
+
+    size_t N = 0;
+    vector < COUNTER > si; // SI contacts of the current slice
+};
+
+// For SIR, a contact that is neither SS nor SI will never transmit again
+// and is removed from its slice for the rest of the realization. The list
+// of remaining contacts of a slice is only set up when the slice is first
+// visited, such that a short realization does not pay for the whole
+// network.
+class ContactRemoval {
+    public:
+        ContactRemoval() : network(nullptr), epoch(0) {}
+
+        void reset(const TemporalNetwork &network)
+        {
+            this->network = &network;
+            live.resize(network.number_of_contacts());
+            live_size.resize(network.number_of_slices());
+            visited.resize(network.number_of_slices(),0);
+            epoch++;
+        }
+
+        template < typename F >
+        void for_each_si_contact(size_t s, const TemporalNetwork::Slice &slice, const STATES &state, const IndexedSet &, F f)
+        {
+            COUNTER *contacts = live.data() + network->first_contact(s);
+            if (visited[s] != epoch)
+            {
+                iota(contacts,contacts+slice.size(),0);
+                live_size[s] = slice.size();
+                visited[s] = epoch;
+            }
+
+            COUNTER size = live_size[s];
+            for(COUNTER k = 0; k < size; )
+            {
+                STATE a = state[slice[contacts[k]].first];
+                STATE b = state[slice[contacts[k]].second];
+                if ((a == SUSCEPTIBLE || b == SUSCEPTIBLE) && a != RECOVERED && b != RECOVERED)
+                {
+                    if (a + b == INFECTED)
+                        f(contacts[k]);
+                    k++;
+                }
+                else
+                    contacts[k] = contacts[--size];
+            }
+            live_size[s] = size;
+        }
+
+    private:
+        const TemporalNetwork *network;
+        vector < COUNTER > live; // per slice, local indices of the contacts not removed yet
+        vector < COUNTER > live_size; // number of contacts not removed, per slice
+        vector < size_t > visited; // realization in which the slice's list was last set up
+        size_t epoch; // current realization
+};
+
+//----------------------------------------------------------------------
+// Infections: sampler over the SI contacts of the current slice
+//----------------------------------------------------------------------
+template < typename RATES >
+class InfectionChannel {
+    public:
+        typedef typename conditional < RATES::uniform, UniformSampler, typename RATES::WEIGHTED_SAMPLER >::type SAMPLER;
+
+        InfectionChannel(double beta, const RATES &rates) : beta(beta), rates(rates) {}
+
+        void reset(size_t max_contacts_per_slice) { sampler.reset(max_contacts_per_slice); }
+
+        // rebuild the set of SI contacts for a new slice
+        template < typename PRUNING >
+        void begin_slice(size_t s, const TemporalNetwork::Slice &slice, const STATES &state, const IndexedSet &infected, PRUNING &pruning)
+        {
+            sampler.clear();
+            pruning.for_each_si_contact(s, slice, state, infected, [&](size_t e)
+            {
+                sampler.insert(e, weight(slice[e], state));
+            });
+        }
+
+        // Update the set of SI contacts after node n changed its state. Only the
+        // contacts of n in the current slice can change between SI and not SI.
+        void update(NODE n, const TemporalNetwork::Slice &slice, const STATES &state)
+        {
+            auto incident = slice.incident(n);
+            for(const COUNTER *e = incident.first; e != incident.second; ++e)
+            {
+                if (is_si(slice[*e], state))
+                    sampler.insert(*e, weight(slice[*e], state));
+                else
+                    sampler.erase(*e);
+            }
+        }
+
+        // draw an SI contact and return its susceptible node
+        NODE sample(const TemporalNetwork::Slice &slice, const STATES &state, ENG &generator)
+        {
+            const CONTACT &contact = slice[sampler.sample(generator)];
+            return state[contact.first] == SUSCEPTIBLE ? contact.first : contact.second;
+        }
+
+        size_t size() const { return sampler.size(); }
+        double total() const { return sampler.total(); }
+        double rate() const { return beta; }
+
+    private:
+        static bool is_si(const CONTACT &contact, const STATES &state)
+        {
+            return state[contact.first] + state[contact.second] == INFECTED;
+        }
+
+        double weight(const CONTACT &contact, const STATES &state) const
+        {
+            if (state[contact.first] == SUSCEPTIBLE)
+                return beta*rates.susceptibility(contact.first)*rates.infectivity(contact.second);
+            else
+                return beta*rates.susceptibility(contact.second)*rates.infectivity(contact.first);
+        }
+
+        double beta;
+        RATES rates;
+        SAMPLER sampler;
+};
+
+//----------------------------------------------------------------------
+// Recoveries: sampler over the infected nodes
+//----------------------------------------------------------------------
+template < typename RECOVERY, typename RATES >
+class RecoveryChannel;
+
+template < typename RATES >
+class RecoveryChannel < ExponentialRecovery, RATES > {
+    public:
+        typedef typename conditional < RATES::uniform, UniformSampler, typename RATES::WEIGHTED_SAMPLER >::type SAMPLER;
+        static const bool time_homogeneous = true; // the rates only change with events
+
+        RecoveryChannel(const ExponentialRecovery &recovery, const RATES &rates) : mu(recovery.mu), rates(rates) {}
+
+        void reset(size_t N) { sampler.reset(N); }
+        void infect(NODE n, double) { sampler.insert(n, mu*rates.recoverability(n)); }
+        void recover(NODE n) { sampler.erase(n); }
+        void begin_slice(size_t) {}
+        void after_event(double) {}
+        NODE sample(ENG &generator) { return sampler.sample(generator); }
+        double total() const { return sampler.total(); }
+        double rate() const { return mu; }
+
+    private:
+        double mu;
+        RATES rates;
+        SAMPLER sampler;
+};
+
+// Recovery rates that change with the age of an infection, for every
+// RECOVERY that can be tabulated (see TabulatedHazard). A node keeps the
+// rate of its current interval of the table until the interval ends; the
+// ends are kept in a heap, such that an event only refreshes the nodes
+// whose interval is over, O(log I) each, instead of recomputing all
+// rates.
+template < typename RECOVERY, typename RATES >
+class RecoveryChannel {
+    public:
+        typedef typename RATES::WEIGHTED_SAMPLER SAMPLER;
+        static const bool time_homogeneous = false;
+
+        RecoveryChannel(const RECOVERY &recovery, const RATES &rates) : hazard(recovery.tabulate()), rates(rates) {}
+
+        void reset(size_t N)
+        {
+            sampler.reset(N);
+            t_infection.assign(N,0.);
+            interval.assign(N,0);
+            t_refresh.assign(N,0.);
+            refreshes = REFRESH_HEAP();
+        }
+
+        void infect(NODE n, double time)
+        {
+            t_infection[n] = time;
+            interval[n] = 0;
+            set_rate(n);
+        }
+
+        void recover(NODE n) { sampler.erase(n); }
+        void begin_slice(size_t t) { refresh((double) t); }
+        void after_event(double time) { refresh(time); }
+        NODE sample(ENG &generator) { return sampler.sample(generator); }
+        double total() const { return sampler.total(); }
+
+    private:
+        typedef pair < double, NODE > REFRESH; // (time, node)
+        typedef priority_queue < REFRESH, vector < REFRESH >, greater < REFRESH > > REFRESH_HEAP;
+
+        // rate of the current interval of n, scheduling its end
+        void set_rate(NODE n)
+        {
+            sampler.insert(n, rates.recoverability(n)*hazard.rate(interval[n]));
+            t_refresh[n] = t_infection[n] + hazard.end(interval[n]);
+            if (isfinite(t_refresh[n]))
+                refreshes.push(REFRESH(t_refresh[n],n));
+        }
+
+        // move all nodes whose interval has ended by time to their current one
+        void refresh(double time)
+        {
+            while (!refreshes.empty() && refreshes.top().first <= time)
+            {
+                REFRESH next = refreshes.top();
+                refreshes.pop();
+                NODE n = next.second;
+                // skip nodes that recovered or were infected anew since
+                if (!sampler.contains(n) || next.first != t_refresh[n])
+                    continue;
+                // at least one interval is over, even if rounding says otherwise
+                interval[n] = hazard.interval(time-t_infection[n], interval[n]+1);
+                set_rate(n);
+            }
+        }
+
+        TabulatedHazard hazard;
+        RATES rates;
+        SAMPLER sampler;
+        vector < double > t_infection; // times at which nodes became infected
+        vector < size_t > interval; // interval of the hazard table of every infected node
+        vector < double > t_refresh; // time at which the interval of a node ends
+        REFRESH_HEAP refreshes; // pending interval ends, may hold outdated entries
+};
+
+//----------------------------------------------------------------------
+// Next contacts of the infected nodes
+//----------------------------------------------------------------------
+// Time of the first slice after the current one in which a node of a set
+// (the infected nodes) has a contact. The nodes are kept in a heap by the
+// time of their next contact, which is looked up again once it has
+// passed. New nodes are only looked up when the time is asked for, and
+// the heap is built anew from the set after more than N of them.
+class NextContacts {
+    public:
+        void reset(size_t N)
+        {
+            contacts = CONTACT_HEAP();
+            time.assign(N,0);
+            arrivals.clear();
+            rebuild = true;
+        }
+
+        void insert(NODE n)
+        {
+            if (rebuild)
+                return;
+            arrivals.push_back(n);
+            if (arrivals.size() > time.size())
+            {
+                arrivals.clear();
+                rebuild = true;
+            }
+        }
+
+        // At time t, in slice s, of the nodes in members. The time is at
+        // most the end of the data (or block), where the nodes are looked
+        // up again.
+        template < typename READER >
+        size_t first(size_t t, size_t s, const IndexedSet &members, READER &slices)
+        {
+            if (rebuild)
+            {
+                contacts = CONTACT_HEAP();
+                arrivals.assign(members.begin(),members.end());
+                rebuild = false;
+            }
+            for(NODE n: arrivals)
+                if (members.contains(n))
+                    look_up(n, t, s, slices);
+            arrivals.clear();
+
+            while (!contacts.empty())
+            {
+                CONTACT_TIME next = contacts.top();
+                NODE n = next.second;
+                // skip nodes that left the set or were looked up anew since
+                if (!members.contains(n) || next.first != time[n])
+                    contacts.pop();
+                else if (next.first > t)
+                    return next.first;
+                else
+                {
+                    contacts.pop();
+                    look_up(n, t, s, slices);
+                }
+            }
+            return numeric_limits < size_t >::max();
+        }
+
+    private:
+        template < typename READER >
+        void look_up(NODE n, size_t t, size_t s, READER &slices)
+        {
+            time[n] = t + slices.next_contact(n, s+1) - s;
+            contacts.push(CONTACT_TIME(time[n],n));
+        }
+
+        typedef pair < size_t, NODE > CONTACT_TIME; // (time, node)
+        typedef priority_queue < CONTACT_TIME, vector < CONTACT_TIME >, greater < CONTACT_TIME > > CONTACT_HEAP;
+
+        CONTACT_HEAP contacts; // may hold outdated entries
+        vector < size_t > time; // time of the next contact of every node in the heap
+        NODES arrivals; // nodes inserted since the last call of first
+        bool rebuild = true; // whether the heap is built from the set at the next call
+};
+
+//======================================================================
+// Parameters and results of an ensemble
+//======================================================================
+struct SimulationParameters {
+    size_t T_simulation = 0; // length of simulation in time steps
+    size_t output_time_resolution = 1; // record a frame every this many time steps
+    size_t number_of_simulations = 1; // ensemble size
+    size_t initial_number_of_infected = 1;
+    size_t seed = 0; // 0 draws a seed from the clock
+    size_t t_infection_start = 0; // slice in which the infection starts
+    bool random_t_infection_start = false; // draw t_infection_start per realization instead
+    bool record_events = false; // record (t, I, SI) at every slice and after every event
+    size_t record_every = 1; // of these, keep every record_every-th
+    double record_min_interval = 0.; // and only if this many time steps after the last one kept
+    bool verbose = false;
+    size_t n_threads = 1; // 0 uses one thread per hardware thread
+    // Keep the frames and final state of every realization. Without, only
+    // the statistics are computed and the memory does not grow with
+    // number_of_simulations (unless events are recorded).
+    bool store_realizations = true;
+    vector < double > quantiles; // of I, SI and R to estimate per frame
+    double quantile_accuracy = 0.01; // relative error of the quantile estimates
+    bool lockstep = true; // run realizations together where possible, see LockstepGillespie
+};
+
+struct EnsembleResult {
+    Array2D < size_t > I; // infected per frame, shape (number_of_simulations, T_simulation/output_time_resolution)
+    Array2D < size_t > SI; // SI contacts per frame, same shape as I
+    Array2D < size_t > R; // recovered per frame (SIR only), same shape as I
+    vector < size_t > final_I; // infected at the end of each realization
+    vector < size_t > final_R; // recovered at the end of each realization
+    vector < char > stopped; // whether the realization died out (I=0)
+    COUNTER number_stopped = 0;
+    double simulation_time = 0.; // wall time in seconds
+    EventRecord events; // if recorded
+    ThreadUtilization threads; // how the realizations were spread over the threads
+    // over all realizations, also without store_realizations
+    FrameStatistics I_statistics;
+    FrameStatistics SI_statistics;
+    FrameStatistics R_statistics; // SIR only
+    vector < size_t > final_I_histogram; // number of realizations ending with I = k, k = 0,...,N
+    vector < size_t > final_R_histogram; // same for R (SIR only)
+};
+
+// Parameters as they are passed to the library functions
+inline SimulationParameters simulation_parameters(size_t T_simulation,
+                                                  size_t output_time_resolution,
+                                                  size_t number_of_simulations,
+                                                  size_t initial_number_of_infected,
+                                                  size_t seed,
+                                                  size_t t_infection_start,
+                                                  bool verbose,
+                                                  size_t n_threads,
+                                                  bool store_realizations,
+                                                  const vector < double > &quantiles,
+                                                  bool record_events,
+                                                  size_t record_every,
+                                                  double record_min_interval
+                                                 )
+{
+    SimulationParameters parameters;
+    parameters.T_simulation = T_simulation;
+    parameters.output_time_resolution = output_time_resolution;
+    parameters.number_of_simulations = number_of_simulations;
+    parameters.initial_number_of_infected = initial_number_of_infected;
+    parameters.seed = seed;
+    parameters.t_infection_start = t_infection_start;
+    parameters.record_events = record_events;
+    parameters.record_every = record_every;
+    parameters.record_min_interval = record_min_interval;
+    parameters.verbose = verbose;
+    parameters.n_threads = n_threads;
+    parameters.store_realizations = store_realizations;
+    parameters.quantiles = quantiles;
+    return parameters;
+}
+
+// Move the output of an ensemble into the result types of the library
+// functions. hist holds the final I (SIS) or the final R (SIR).
+inline SI_result as_SI_result(EnsembleResult &ensemble)
+{
+    SI_result result;
+    result.events = move(ensemble.events);
+    result.I = ensemble.I;
+    result.SI = ensemble.SI;
+    result.hist.swap(ensemble.final_I);
+    result.I_statistics = ensemble.I_statistics;
+    result.SI_statistics = ensemble.SI_statistics;
+    result.final_size_histogram.swap(ensemble.final_I_histogram);
+    result.threads = ensemble.threads;
+    return result;
+}
+
+inline SIR_result as_SIR_result(EnsembleResult &ensemble)
+{
+    SIR_result result;
+    result.events = move(ensemble.events);
+    result.I = ensemble.I;
+    result.SI = ensemble.SI;
+    result.R = ensemble.R;
+    result.hist.swap(ensemble.final_R);
+    result.I_statistics = ensemble.I_statistics;
+    result.SI_statistics = ensemble.SI_statistics;
+    result.R_statistics = ensemble.R_statistics;
+    result.final_size_histogram.swap(ensemble.final_R_histogram);
+    result.threads = ensemble.threads;
+    return result;
+}
+
+//======================================================================
+// Engine
+//======================================================================
+// Holds the buffers of a single realization, so an ensemble uses one copy
+// per thread.
+template < typename MODEL,
+           typename RATES = HomogeneousRates,
+           typename PRUNING = NoPruning,
+           typename RECOVERY = ExponentialRecovery,
+           typename NETWORK = TemporalNetwork
+         >
+class TemporalGillespie {
+    public:
+        typedef MODEL COMPARTMENT_MODEL;
+
+        TemporalGillespie(const NETWORK &network,
+                          double beta,
+                          const RECOVERY &recovery,
+                          const RATES &rates = RATES(),
+                          const PRUNING &pruning = PRUNING()
+                         )
+            : network(&network), slices(&network), infection(beta, rates), recovery(recovery, rates), pruning(pruning)
+        {
+            static_assert(MODEL::immunity || is_same < PRUNING, NoPruning >::value,
+                          "Contacts can only be removed if recovered nodes are immune");
+            static_assert(is_same < PRUNING, NoPruning >::value || is_same < NETWORK, TemporalNetwork >::value,
+                          "Contacts can only be removed from a network held in memory");
+        }
+
+        const NETWORK & get_network() const { return *network; }
+        double infection_rate() const { return infection.rate(); } // beta
+        double recovery_rate() const { return recovery.rate(); } // mu, for ExponentialRecovery only
+
+        // Runs one realization drawing from generator. Writes frame k to
+        // I_t[k], SI_t[k] and R_t[k] (R_t may be null) for all
+        // T_simulation/output_time_resolution frames.
+        void simulate(const SimulationParameters &parameters,
+                      ENG &generator,
+                      size_t *I_t,
+                      size_t *SI_t,
+                      size_t *R_t,
+                      const atomic < bool > *cancel = nullptr
+                     );
+
+        COUNTER infected() const { return I; }
+        COUNTER recovered() const { return R; }
+        COUNTER peak_infected() const { return peak_I; } // largest I of the last realization
+        bool stopped() const { return has_stopped; }
+
+        // event-resolved output of the last realization
+        vector < uint32_t > true_I;
+        vector < uint32_t > true_SI;
+        vector < float > true_t;
+
+    private:
+        void infect(NODE n, double time)
+        {
+            state[n] = INFECTED;
+            infected_nodes.insert(n);
+            next_contacts.insert(n);
+            recovery.infect(n, time);
+            I++;
+            if (I > peak_I)
+                peak_I = I;
+        }
+
+        void recover(NODE n)
+        {
+            state[n] = MODEL::immunity ? RECOVERED : SUSCEPTIBLE;
+            infected_nodes.erase(n);
+            recovery.recover(n);
+            I--;
+            if (MODEL::immunity)
+                R++;
+        }
+
+        void record_event(bool record, double time)
+        {
+            if (!record)
+                return;
+            // decimation: every record_every-th entry, at least record_min_interval apart
+            if (entries_seen++ % record_every != 0 || time < last_recorded + record_min_interval)
+                return;
+            last_recorded = time;
+            true_t.push_back(time);
+            true_I.push_back(I);
+            true_SI.push_back(infection.size());
+        }
+
+        const NETWORK *network;
+        typename NETWORK::Reader slices; // hands out the slices in order
+        InfectionChannel < RATES > infection;
+        RecoveryChannel < RECOVERY, RATES > recovery;
+        PRUNING pruning;
+
+        STATES state; // compartment of every node, padded for find_si_contacts
+        IndexedSet infected_nodes; // the SI contacts of a slice can be found from them
+        NextContacts next_contacts; // of the infected nodes, for skipping slices
+        COUNTER I = 0; // number of infected nodes
+        COUNTER R = 0; // number of recovered nodes
+        COUNTER peak_I = 0; // largest I so far
+        bool has_stopped = false;
+        size_t record_every = 1;
+        double record_min_interval = 0.;
+        size_t entries_seen = 0; // entries of the realization, recorded or not
+        double last_recorded = 0.; // time of the last recorded entry
+        vector < size_t > roots; // for choosing the initially infected nodes
+        DIST_REAL rand{0.0,1.0}; // random float on [0,1[
+        DIST_EXP randexp{1.0}; // random exponentially distributed float
+};
+
+template < typename MODEL, typename RATES, typename PRUNING, typename RECOVERY, typename NETWORK >
+void TemporalGillespie < MODEL, RATES, PRUNING, RECOVERY, NETWORK >::simulate(const SimulationParameters &parameters,
+                                                                    ENG &generator,
+                                                                    size_t *I_t,
+                                                                    size_t *SI_t,
+                                                                    size_t *R_t,
+                                                                    const atomic < bool > *cancel
+                                                                   )
+{
+    size_t N = network->number_of_nodes();
+    size_t T_data = network->number_of_slices();
+    size_t T_simulation = parameters.T_simulation;
+    size_t outputTimeResolution = parameters.output_time_resolution;
+    size_t frames = T_simulation/outputTimeResolution;
+    bool record = parameters.record_events;
+    // Without events, the state and so the total rate are the same in a
+    // run of identical slices, or in slices in which no infected node has
+    // a contact, unless the recovery rates depend on time. Slices are not
+    // skipped when the start of every slice is recorded.
+    bool skip_slices = RecoveryChannel < RECOVERY, RATES >::time_homogeneous && !record;
+    // The next contact of an infected node is only looked up while they
+    // have less than one contact per slice together, else it costs more
+    // than going through the slices.
+    double contacts_per_node = 2.*network->number_of_contacts()/((double) N*T_data);
+
+    double Beta; //total infection rate
+    double Lambda; //total transition rate
+    double xi; //fraction of time-step left
+    double tau; //renormalized waiting time until next event
+    double t_transition; //time of the current event
+    size_t t; //time counter
+    size_t s; //current slice
+    NODE n; //node changing its state
+
+    true_I.clear();
+    true_SI.clear();
+    true_t.clear();
+    record_every = parameters.record_every;
+    record_min_interval = parameters.record_min_interval;
+    entries_seen = 0;
+    last_recorded = -numeric_limits < double >::infinity();
+    has_stopped = false;
+
+    // Choose at random infectious root nodes:
+    roots.resize(N);
+    iota(roots.begin(),roots.end(),0);
+    choose_random_unique(roots.begin(),roots.end(),parameters.initial_number_of_infected,generator,rand);
+
+    state.assign(N+STATE_PADDING,SUSCEPTIBLE);
+    if (infected_nodes.capacity() != N)
+        infected_nodes.reset(N);
+    infected_nodes.clear();
+    next_contacts.reset(N);
+    infection.reset(network->max_contacts_per_slice());
+    recovery.reset(N);
+    pruning.reset(*network);
+    I = 0;
+    R = 0;
+    peak_I = 0;
+    for(size_t k = 0; k < parameters.initial_number_of_infected; ++k)
+        infect(roots[k], 0.);
+
+    // starting time of infection:
+    s = parameters.t_infection_start;
+    if (parameters.random_t_infection_start)
+        s = (size_t) (T_data*rand(generator));
+    if (s >= T_data)
+        s = 0;
+
+    // First waiting time:
+    tau = randexp(generator);
+    // set simulation time to zero:
+    t = 0;
+
+    //--- Loop over slices, starting over at the end of the data: ---
+    while(I>0 && t<T_simulation)
+    {
+        const TemporalNetwork::Slice slice = slices.slice(s);
+        check_cancelled(cancel);
+
+        recovery.begin_slice(t);
+        infection.begin_slice(s, slice, state, infected_nodes, pruning);
+        record_event(record, (double) t);
+
+        Beta = infection.total();
+        Lambda = Beta + recovery.total();
+
+        // Skip a run of identical slices without transitions, and without
+        // SI contacts also the slices up to the next contact of an
+        // infected node while nobody recovers:
+        size_t skipped = 0;
+        size_t run = skip_slices ? min(slices.repeats(s), T_simulation-t) : 1;
+        if(skip_slices && infection.size()==0 && tau>=Lambda)
+        {
+            size_t quiet = t+run;
+            if(I*contacts_per_node<1.)
+                quiet = max(quiet, min(min(t+T_data-s, T_simulation), next_contacts.first(t, s, infected_nodes, slices)));
+            // as slice by slice, so that the result does not depend on quiet
+            for(; t+skipped<quiet && tau>=Lambda; ++skipped)
+                tau-=Lambda;
+        }
+        else if(run>1 && tau>=run*Lambda)
+        {
+            tau-=run*Lambda;
+            skipped = run;
+        }
+        if(skipped>0)
+        {
+            for(size_t k = (t+outputTimeResolution-1)/outputTimeResolution; k*outputTimeResolution < t+skipped && k < frames; ++k)
+            {
+                I_t[k] = I;
+                SI_t[k] = infection.size();
+                if (R_t)
+                    R_t[k] = R;
+            }
+            t += skipped;
+            s += skipped;
+            if (s == T_data)
+                s = 0;
+            continue;
+        }
+
+        // Check if transition takes place during time-step:
+        if(tau>=Lambda) //no transition takes place
+        {
+            tau-=Lambda;
+        }
+        else //at least one transition takes place
+        {
+            xi=1.; //fraction of time-step left before transition
+            t_transition = (double) t;
+            // Sampling step:
+            while(tau<xi*Lambda) //repeat if next tau is smaller than ~ Lambda-tau
+            {
+                xi-=tau/Lambda; //fraction of time-step left after transition
+                t_transition+=tau/Lambda; //current time
+                if(Lambda*rand(generator)<Beta) //S->I
+                {
+                    n = infection.sample(slice, state, generator);
+                    infect(n, t_transition);
+                }
+                else //I->R (or I->S)
+                {
+                    n = recovery.sample(generator);
+                    recover(n);
+                }
+                infection.update(n, slice, state);
+                recovery.after_event(t_transition);
+                record_event(record, t_transition);
+
+                Beta = infection.total();
+                Lambda = Beta + recovery.total(); //new cumulative transition rate
+                // Draw new renormalized waiting time:
+                tau = randexp(generator);
+            }
+            tau -= xi*Lambda;
+        }
+        // Stop if I=0, the remaining frames keep the final state:
+        if(I==0)
+        {
+            has_stopped = true;
+            for(size_t k = (t+outputTimeResolution-1)/outputTimeResolution; k < frames; ++k)
+            {
+                I_t[k] = 0;
+                SI_t[k] = 0;
+                if (R_t)
+                    R_t[k] = R;
+            }
+            break;
+        }
+        // read out I, SI and R if t is divisible by outputTimeResolution
+        if(t % outputTimeResolution ==0 && t/outputTimeResolution < frames)
+        {
+            I_t[t/outputTimeResolution] = I;
+            SI_t[t/outputTimeResolution] = infection.size();
+            if (R_t)
+                R_t[t/outputTimeResolution] = R;
+        }
+        t++;
+        if (++s == T_data)
+            s = 0;
+    }
+}
+
+//======================================================================
+// Engine for many realizations in lockstep
+//======================================================================
+// Homogeneous Poissonian realizations spend most of their time going
+// through the contacts of every slice. This engine runs up to LANES
+// realizations ("lanes") together on the same slices: the compartments
+// of a node are kept as bit masks with one bit per lane, such that one
+// pass over the contacts of a slice finds the SI contacts of all lanes
+// with a few word operations, and counts them per lane. Only the lanes
+// in which an event happens during the slice then go through their own
+// SI contacts, and draw their events like TemporalGillespie.
+//
+// Every lane draws the same random numbers in the same order as
+// TemporalGillespie < MODEL > in the same realization, so the results are
+// identical; run_ensemble switches to this engine where it can (see
+// LockstepOf and lockstep_lanes). A lane skips slices whenever
+// TemporalGillespie does. Event recording and random starting
+// slices are not supported. The memory is O(LANES*N) per engine.
+template < typename MODEL, typename NETWORK = TemporalNetwork >
+class LockstepGillespie {
+    public:
+        typedef MODEL COMPARTMENT_MODEL;
+        typedef uint64_t LANE_MASK; // bit l for lane l
+        static const size_t LANES = 64;
+
+        explicit LockstepGillespie(const TemporalGillespie < MODEL, HomogeneousRates, NoPruning, ExponentialRecovery, NETWORK > &engine)
+            : network(&engine.get_network()), slices(network), beta(engine.infection_rate()), mu(engine.recovery_rate()), lanes(LANES)
+        {}
+
+        // Runs the realizations first,...,first+number_of_lanes-1, lane l
+        // drawing from realization_generator(parameters.seed, first+l) and
+        // writing its frames to I_t[l], SI_t[l] and R_t[l] (R_t[l] may be
+        // null) as TemporalGillespie::simulate does.
+        void simulate(const SimulationParameters &parameters,
+                      size_t first,
+                      size_t number_of_lanes,
+                      size_t * const *I_t,
+                      size_t * const *SI_t,
+                      size_t * const *R_t,
+                      const atomic < bool > *cancel = nullptr
+                     );
+
+        COUNTER infected(size_t l) const { return lanes[l].I; }
+        COUNTER recovered(size_t l) const { return lanes[l].R; }
+        COUNTER peak_infected(size_t l) const { return lanes[l].peak_I; }
+        bool stopped(size_t l) const { return lanes[l].has_stopped; }
+
+    private:
+        struct Lane {
+            ENG generator;
+            IndexedSet infected; // in the order of the recovery sampler of TemporalGillespie
+            double tau = 0.; // renormalized waiting time until the next event
+            size_t skipped_until = 0; // end of the slices skipped at once
+            COUNTER I = 0;
+            COUNTER R = 0;
+            COUNTER peak_I = 0;
+            bool has_stopped = false;
+        };
+
+        static LANE_MASK bit(size_t l) { return (LANE_MASK) 1 << l; }
+
+        bool is_infected(NODE n, size_t l) const { return (infected_mask[n] >> l) & 1; }
+        bool is_susceptible(NODE n, size_t l) const
+        {
+            LANE_MASK not_susceptible = MODEL::immunity ? infected_mask[n] | recovered_mask[n] : infected_mask[n];
+            return !((not_susceptible >> l) & 1);
+        }
+        bool is_si(const CONTACT &contact, size_t l) const
+        {
+            return (is_infected(contact.first, l) && is_susceptible(contact.second, l)) ||
+                   (is_infected(contact.second, l) && is_susceptible(contact.first, l));
+        }
+
+        // lanes in which contact is SI
+        LANE_MASK si_lanes(const CONTACT &contact) const
+        {
+            NODE i = contact.first, j = contact.second;
+            LANE_MASK susceptible_i = ~infected_mask[i], susceptible_j = ~infected_mask[j];
+            if (MODEL::immunity)
+            {
+                susceptible_i &= ~recovered_mask[i];
+                susceptible_j &= ~recovered_mask[j];
+            }
+            return (infected_mask[i] & susceptible_j) | (infected_mask[j] & susceptible_i);
+        }
+
+        void infect(size_t l, NODE n)
+        {
+            Lane &lane = lanes[l];
+            if (!infected_mask[n])
+            {
+                carriers.insert(n);
+                next_contacts.insert(n);
+            }
+            infected_mask[n] |= bit(l);
+            lane.infected.insert(n);
+            if (++lane.I > lane.peak_I)
+                lane.peak_I = lane.I;
+        }
+
+        void recover(size_t l, NODE n)
+        {
+            Lane &lane = lanes[l];
+            infected_mask[n] &= ~bit(l);
+            if (!infected_mask[n])
+                carriers.erase(n);
+            lane.infected.erase(n);
+            lane.I--;
+            if (MODEL::immunity)
+            {
+                recovered_mask[n] |= bit(l);
+                lane.R++;
+            }
+        }
+
+        // SI contacts of every lane in the slice, into si_contacts, si_mask
+        // and si_count
+        void find_si_contacts(const TemporalNetwork::Slice &slice);
+
+        // the events of lane l in slice, returns the number of SI contacts
+        // at its end
+        size_t run_events(size_t l, const TemporalNetwork::Slice &slice);
+
+        const NETWORK *network;
+        typename NETWORK::Reader slices;
+        double beta;
+        double mu;
+
+        vector < Lane > lanes;
+        vector < LANE_MASK > infected_mask; // per node
+        vector < LANE_MASK > recovered_mask; // per node (SIR only)
+        IndexedSet carriers; // nodes infected in any lane
+        NextContacts next_contacts; // of the carriers
+        vector < COUNTER > si_contacts; // contacts of the current slice that are SI in any lane, in order
+        vector < LANE_MASK > si_mask; // per contact of the current slice, valid for si_contacts
+        COUNTER si_count[LANES]; // SI contacts of the current slice per lane
+        IndexedSet si; // SI contacts of the lane that is drawing events
+        vector < size_t > roots; // for choosing the initially infected nodes
+        DIST_REAL rand{0.0,1.0}; // random float on [0,1[
+        DIST_EXP randexp{1.0}; // random exponentially distributed float
+};
+
+template < typename MODEL, typename NETWORK >
+void LockstepGillespie < MODEL, NETWORK >::find_si_contacts(const TemporalNetwork::Slice &slice)
+{
+    fill(si_count, si_count+LANES, 0);
+    // contact e is kept if it is SI in any lane
+    auto add = [&](COUNTER e, size_t &k)
+    {
+        LANE_MASK m = si_lanes(slice[e]);
+        if (!m)
+            return;
+        si_mask[e] = m;
+        si_contacts[k++] = e;
+        for(; m; m &= m-1)
+            si_count[__builtin_ctzll(m)]++;
+    };
+
+    size_t k = 0;
+    if (scan_from_infected(carriers.size(), slice.size(), network->number_of_nodes()))
+    {
+        // the contacts of the carriers, a contact between two of them is listed twice
+        si_contacts.clear();
+        for(size_t n: carriers)
+        {
+            auto incident = slice.incident((NODE) n);
+            si_contacts.insert(si_contacts.end(), incident.first, incident.second);
+        }
+        sort(si_contacts.begin(), si_contacts.end());
+        size_t candidates = unique(si_contacts.begin(), si_contacts.end()) - si_contacts.begin();
+        for(size_t c = 0; c < candidates; ++c)
+            add(si_contacts[c], k);
+    }
+    else
+    {
+        si_contacts.resize(slice.size());
+        for(size_t e = 0; e < slice.size(); ++e)
+            add(e, k);
+    }
+    si_contacts.resize(k);
+}
+
+template < typename MODEL, typename NETWORK >
+size_t LockstepGillespie < MODEL, NETWORK >::run_events(size_t l, const TemporalNetwork::Slice &slice)
+{
+    Lane &lane = lanes[l];
+    ENG &generator = lane.generator;
+
+    // the SI contacts of the lane, in the order TemporalGillespie inserts them
+    si.clear();
+    for(COUNTER e: si_contacts)
+        if ((si_mask[e] >> l) & 1)
+            si.insert(e);
+
+    double Beta = beta*si.size();
+    double Lambda = Beta + mu*lane.I;
+    double xi = 1.;
+    while(lane.tau<xi*Lambda)
+    {
+        xi-=lane.tau/Lambda;
+        NODE n;
+        if(Lambda*rand(generator)<Beta) //S->I
+        {
+            const CONTACT &contact = slice[si[(size_t) (si.size() * rand(generator))]];
+            n = is_susceptible(contact.first, l) ? contact.first : contact.second;
+            infect(l, n);
+        }
+        else //I->R (or I->S)
+        {
+            n = (NODE) lane.infected[(size_t) (lane.infected.size() * rand(generator))];
+            recover(l, n);
+        }
+        auto incident = slice.incident(n);
+        for(const COUNTER *e = incident.first; e != incident.second; ++e)
+        {
+            if (is_si(slice[*e], l))
+                si.insert(*e);
+            else
+                si.erase(*e);
+        }
+
+        Beta = beta*si.size();
+        Lambda = Beta + mu*lane.I;
+        lane.tau = randexp(generator);
+    }
+    lane.tau -= xi*Lambda;
+    return si.size();
+}
+
+template < typename MODEL, typename NETWORK >
+void LockstepGillespie < MODEL, NETWORK >::simulate(const SimulationParameters &parameters,
+                                                    size_t first,
+                                                    size_t number_of_lanes,
+                                                    size_t * const *I_t,
+                                                    size_t * const *SI_t,
+                                                    size_t * const *R_t,
+                                                    const atomic < bool > *cancel
+                                                   )
+{
+    size_t N = network->number_of_nodes();
+    size_t T_data = network->number_of_slices();
+    size_t T_simulation = parameters.T_simulation;
+    size_t outputTimeResolution = parameters.output_time_resolution;
+    size_t frames = T_simulation/outputTimeResolution;
+    double contacts_per_node = 2.*network->number_of_contacts()/((double) N*T_data);
+
+    if (number_of_lanes > LANES || parameters.record_events || parameters.random_t_infection_start)
+        throw logic_error("LockstepGillespie runs at most 64 realizations, without events or random starting slices");
+
+    infected_mask.assign(N,0);
+    recovered_mask.assign(MODEL::immunity ? N : 0,0);
+    carriers.reset(N);
+    next_contacts.reset(N);
+    si_contacts.reserve(2*network->max_contacts_per_slice());
+    si_mask.resize(network->max_contacts_per_slice());
+    si.reset(network->max_contacts_per_slice());
+
+    // Start every lane as TemporalGillespie starts a realization:
+    LANE_MASK alive = 0; // lanes that still have infected nodes
+    for(size_t l = 0; l < number_of_lanes; ++l)
+    {
+        Lane &lane = lanes[l];
+        lane.generator = realization_generator(parameters.seed, first+l);
+        lane.infected.reset(N);
+        lane.I = 0;
+        lane.R = 0;
+        lane.peak_I = 0;
+        lane.has_stopped = false;
+        lane.skipped_until = 0;
+
+        roots.resize(N);
+        iota(roots.begin(),roots.end(),0);
+        choose_random_unique(roots.begin(),roots.end(),parameters.initial_number_of_infected,lane.generator,rand);
+        for(size_t k = 0; k < parameters.initial_number_of_infected; ++k)
+            infect(l, roots[k]);
+        lane.tau = randexp(lane.generator);
+
+        if (lane.I > 0)
+            alive |= bit(l);
+    }
+
+    size_t s = parameters.t_infection_start;
+    if (s >= T_data)
+        s = 0;
+
+    //--- Loop over slices, all lanes at once: ---
+    for(size_t t = 0; alive && t < T_simulation; ++t)
+    {
+        // lanes that are not in a run of slices they skip
+        LANE_MASK pending = 0;
+        for(LANE_MASK a = alive; a; a &= a-1)
+            if (lanes[__builtin_ctzll(a)].skipped_until <= t)
+                pending |= bit(__builtin_ctzll(a));
+        if (!pending)
+        {
+            // go on with the first lane that stops skipping
+            size_t next = T_simulation;
+            for(LANE_MASK a = alive; a; a &= a-1)
+                next = min(next, lanes[__builtin_ctzll(a)].skipped_until);
+            s += next-t;
+            if (s == T_data)
+                s = 0;
+            t = next-1;
+            continue;
+        }
+
+        const TemporalNetwork::Slice slice = slices.slice(s);
+        check_cancelled(cancel);
+        find_si_contacts(slice);
+        size_t run = min(slices.repeats(s), T_simulation-t);
+        size_t contact = 0; // looked up for the first lane without SI contacts
+        bool sparse = carriers.size()*contacts_per_node < 1.; // whether to look it up, see TemporalGillespie::simulate
+
+        for(; pending; pending &= pending-1)
+        {
+            size_t l = __builtin_ctzll(pending);
+            Lane &lane = lanes[l];
+
+            size_t SI = si_count[l];
+            double Lambda = beta*SI + mu*lane.I;
+            // skip slices as TemporalGillespie does
+            size_t skipped = 0;
+            if(SI==0 && lane.tau>=Lambda)
+            {
+                // up to the next contact of a node infected in any lane
+                if (sparse && contact == 0)
+                    contact = min(min(t+T_data-s, T_simulation), next_contacts.first(t, s, carriers, slices));
+                for(size_t quiet = max(t+run, contact); t+skipped<quiet && lane.tau>=Lambda; ++skipped)
+                    lane.tau-=Lambda;
+            }
+            else if(run>1 && lane.tau>=run*Lambda)
+            {
+                lane.tau-=run*Lambda;
+                skipped = run;
+            }
+            if(skipped>0)
+            {
+                lane.skipped_until = t+skipped;
+                for(size_t k = (t+outputTimeResolution-1)/outputTimeResolution; k*outputTimeResolution < t+skipped && k < frames; ++k)
+                {
+                    I_t[l][k] = lane.I;
+                    SI_t[l][k] = SI;
+                    if (R_t[l])
+                        R_t[l][k] = lane.R;
+                }
+                continue;
+            }
+            if(lane.tau>=Lambda) //no transition takes place
+                lane.tau-=Lambda;
+            else
+                SI = run_events(l, slice);
+
+            // Stop if I=0, the remaining frames keep the final state:
+            if(lane.I==0)
+            {
+                lane.has_stopped = true;
+                alive &= ~bit(l);
+                for(size_t k = (t+outputTimeResolution-1)/outputTimeResolution; k < frames; ++k)
+                {
+                    I_t[l][k] = 0;
+                    SI_t[l][k] = 0;
+                    if (R_t[l])
+                        R_t[l][k] = lane.R;
+                }
+                continue;
+            }
+            // read out I, SI and R if t is divisible by outputTimeResolution
+            if(t % outputTimeResolution ==0 && t/outputTimeResolution < frames)
+            {
+                I_t[l][t/outputTimeResolution] = lane.I;
+                SI_t[l][t/outputTimeResolution] = SI;
+                if (R_t[l])
+                    R_t[l][t/outputTimeResolution] = lane.R;
+            }
+        }
+        if (++s == T_data)
+            s = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Which engines have a lockstep variant
+//----------------------------------------------------------------------
+// Stands in for the lockstep variant of engines that have none.
+struct NoLockstep {
+    static const size_t LANES = 0;
+
+    template < typename ENGINE >
+    explicit NoLockstep(const ENGINE &) {}
+
+    void simulate(const SimulationParameters &, size_t, size_t, size_t * const *, size_t * const *, size_t * const *,
+                  const atomic < bool > * = nullptr) {}
+    COUNTER infected(size_t) const { return 0; }
+    COUNTER recovered(size_t) const { return 0; }
+    COUNTER peak_infected(size_t) const { return 0; }
+    bool stopped(size_t) const { return false; }
+};
+
+template < typename ENGINE >
+struct LockstepOf { typedef NoLockstep type; };
+
+template < typename MODEL, typename NETWORK >
+struct LockstepOf < TemporalGillespie < MODEL, HomogeneousRates, NoPruning, ExponentialRecovery, NETWORK > > {
+    typedef LockstepGillespie < MODEL, NETWORK > type;
+};
+
+// Number of realizations a LOCKSTEP engine should run together in an
+// ensemble of Q realizations on n_threads threads, 0 if they are better
+// run one by one: lanes only pay off in numbers, and every thread should
+// get a batch.
+template < typename LOCKSTEP >
+size_t lockstep_lanes(size_t N, const SimulationParameters &parameters, size_t Q, size_t n_threads)
+{
+    const size_t MIN_LANES = 8;
+    const size_t MAX_LANE_NODES = (size_t) 1 << 23; // lanes*N, i.e. 64 MB of per-lane node indexes
+    if (LOCKSTEP::LANES == 0 || !parameters.lockstep || parameters.record_events || parameters.random_t_infection_start)
+        return 0;
+    size_t lanes = min((size_t) LOCKSTEP::LANES, (Q + n_threads - 1) / max(n_threads, (size_t) 1));
+    if (lanes < MIN_LANES || lanes * N > MAX_LANE_NODES)
+        return 0;
+    return lanes;
+}
+
+//======================================================================
+// Ensemble of independent realizations
+//======================================================================
+// Throws invalid_argument if the parameters do not fit the network.
+template < typename NETWORK >
+void check_parameters(const NETWORK &network, const SimulationParameters &parameters)
+{
+    if (parameters.output_time_resolution == 0)
+        throw invalid_argument("output_time_resolution has to be > 0");
+    if (parameters.initial_number_of_infected > network.number_of_nodes())
+        throw invalid_argument("initial_number_of_infected has to be <= N");
+    if (network.number_of_slices() == 0 && parameters.T_simulation > 0)
+        throw invalid_argument("The temporal network has no time slices");
+    if (parameters.t_infection_start > network.number_of_slices())
+        throw invalid_argument("t_infection_start has to be <= number of slices");
+    for(auto const &quantile: parameters.quantiles)
+        if (!(quantile >= 0 && quantile <= 1))
+            throw invalid_argument("quantiles have to be in [0,1]");
+    if (parameters.record_events && parameters.record_every == 0)
+        throw invalid_argument("record_every has to be > 0");
+}
+
+// Runs parameters.number_of_simulations realizations of the engine, each
+// drawing from its own random stream (see realization_generator), on
+// parameters.n_threads threads. Every thread accumulates the statistics
+// of its realizations, they are merged at the end.
+template < typename ENGINE >
+EnsembleResult run_ensemble(const ENGINE &engine,
+                            SimulationParameters parameters,
+                            const atomic < bool > *cancel = nullptr
+                           )
+{
+    const auto &network = engine.get_network();
+    const bool immunity = ENGINE::COMPARTMENT_MODEL::immunity;
+    size_t N = network.number_of_nodes();
+    size_t Q = parameters.number_of_simulations;
+    size_t frames;
+
+    check_parameters(network, parameters);
+
+    frames = parameters.T_simulation/parameters.output_time_resolution;
+    size_t n_threads = number_of_threads(parameters.n_threads, Q);
+    bool store = parameters.store_realizations;
+
+    // Engines per thread, running realizations one by one or in batches of lanes
+    typedef typename LockstepOf < ENGINE >::type LOCKSTEP;
+    size_t lanes = lockstep_lanes < LOCKSTEP >(N, parameters, Q, n_threads);
+    size_t batches = lanes > 0 ? (Q + lanes - 1) / lanes : 0;
+    if (lanes > 0)
+        n_threads = number_of_threads(n_threads, batches);
+    vector < ENGINE > engines(lanes > 0 ? 0 : n_threads, engine);
+    vector < LOCKSTEP > lockstep_engines(lanes > 0 ? n_threads : 0, LOCKSTEP(engine));
+
+    // Containers for output data:
+    EnsembleResult result;
+    if (store)
+    {
+        result.I = Array2D < size_t >(Q,frames);
+        result.SI = Array2D < size_t >(Q,frames);
+        if (immunity)
+            result.R = Array2D < size_t >(Q,frames);
+        result.final_I.resize(Q);
+        result.final_R.resize(Q);
+        result.stopped.resize(Q);
+    }
+    size_t recorded = parameters.record_events ? Q : 0;
+    vector < vector < uint32_t > > true_I(recorded);
+    vector < vector < uint32_t > > true_SI(recorded);
+    vector < vector < float > > true_t(recorded);
+
+    // Statistics, per thread:
+    struct ThreadStatistics {
+        FrameMoments I, SI, R;
+        vector < size_t > final_I, final_R; // histograms
+        size_t stopped = 0;
+        Array2D < size_t > frames; // I, SI and R of the current realization(s) if they are not stored
+    };
+    vector < ThreadStatistics > statistics(n_threads);
+    for(auto &thread_statistics: statistics)
+    {
+        thread_statistics.I.reset(frames);
+        thread_statistics.SI.reset(frames);
+        thread_statistics.R.reset(immunity ? frames : 0);
+        thread_statistics.final_I.assign(N+1,0);
+        thread_statistics.final_R.assign(immunity ? N+1 : 0,0);
+        if (!store)
+            thread_statistics.frames = Array2D < size_t >(3*max(lanes, (size_t) 1),frames);
+    }
+    // and shared by all threads
+    bool with_quantiles = !parameters.quantiles.empty();
+    FrameQuantileSketch I_sketch, SI_sketch, R_sketch;
+    if (with_quantiles)
+    {
+        I_sketch.reset(frames, N, parameters.quantile_accuracy);
+        SI_sketch.reset(frames, network.max_contacts_per_slice(), parameters.quantile_accuracy);
+        if (immunity)
+            R_sketch.reset(frames, N, parameters.quantile_accuracy);
+    }
+
+    // Random number generators: every realization q draws from its own
+    // stream derived from (seed, q)
+    if (parameters.seed==0)
+        parameters.seed = time(nullptr);
+
+    // Where realization q writes its frames, as lane l of thread
+    auto frame_rows = [&](size_t q, size_t thread, size_t l, size_t *&I_t, size_t *&SI_t, size_t *&R_t)
+    {
+        Array2D < size_t > &buffer = statistics[thread].frames;
+        I_t = store ? result.I.row(q) : buffer.row(3*l);
+        SI_t = store ? result.SI.row(q) : buffer.row(3*l+1);
+        R_t = !immunity ? nullptr : store ? result.R.row(q) : buffer.row(3*l+2);
+    };
+    // Statistics of realization q
+    auto collect = [&](size_t q, size_t thread, const size_t *I_t, const size_t *SI_t, const size_t *R_t,
+                       COUNTER infected, COUNTER recovered, bool stopped)
+    {
+        ThreadStatistics &stats = statistics[thread];
+        stats.I.add(I_t);
+        stats.SI.add(SI_t);
+        stats.final_I[infected]++;
+        if (immunity)
+        {
+            stats.R.add(R_t);
+            stats.final_R[recovered]++;
+        }
+        stats.stopped += stopped;
+        if (with_quantiles)
+        {
+            I_sketch.add(I_t);
+            SI_sketch.add(SI_t);
+            if (immunity)
+                R_sketch.add(R_t);
+        }
+
+        if (store)
+        {
+            result.final_I[q] = infected;
+            result.final_R[q] = recovered;
+            result.stopped[q] = stopped;
+        }
+    };
+
+    auto start = chrono::steady_clock::now(); //timer
+    if (lanes > 0)
+    {
+        result.threads = parallel_for(batches, n_threads, [&](size_t b, size_t thread)
+        {
+            size_t first = b*lanes;
+            size_t number_of_lanes = min(lanes, Q-first);
+            if (parameters.verbose)
+                cout << first << "-" << first+number_of_lanes-1 << "/" << Q << endl;
+
+            LOCKSTEP &e = lockstep_engines[thread];
+            vector < size_t* > I_t(number_of_lanes), SI_t(number_of_lanes), R_t(number_of_lanes);
+            for(size_t l = 0; l < number_of_lanes; ++l)
+                frame_rows(first+l, thread, l, I_t[l], SI_t[l], R_t[l]);
+            e.simulate(parameters, first, number_of_lanes, I_t.data(), SI_t.data(), R_t.data(), cancel);
+
+            for(size_t l = 0; l < number_of_lanes; ++l)
+                collect(first+l, thread, I_t[l], SI_t[l], R_t[l], e.infected(l), e.recovered(l), e.stopped(l));
+        });
+    }
+    else
+    {
+        result.threads = parallel_for(Q, n_threads, [&](size_t q, size_t thread)
+        {
+            if (parameters.verbose)
+                cout << q << "/" << Q << endl; //print realization # to screen
+
+            ENGINE &e = engines[thread];
+            ENG generator = realization_generator(parameters.seed, q);
+
+            size_t *I_t, *SI_t, *R_t;
+            frame_rows(q, thread, 0, I_t, SI_t, R_t);
+            e.simulate(parameters, generator, I_t, SI_t, R_t, cancel);
+            collect(q, thread, I_t, SI_t, R_t, e.infected(), e.recovered(), e.stopped());
+
+            if (parameters.record_events)
+            {
+                true_I[q].swap(e.true_I);
+                true_SI[q].swap(e.true_SI);
+                true_t[q].swap(e.true_t);
+            }
+        });
+    }
+    result.simulation_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Concatenate the events of all realizations in order of q:
+    if (recorded > 0)
+    {
+        EventRecord &events = result.events;
+        events.offsets.assign(Q+1,0);
+        for(size_t q = 0; q < Q; ++q)
+            events.offsets[q+1] = events.offsets[q] + true_t[q].size();
+        events.t.reserve(events.offsets[Q]);
+        events.I.reserve(events.offsets[Q]);
+        events.SI.reserve(events.offsets[Q]);
+        for(size_t q = 0; q < Q; ++q)
+        {
+            events.t.insert(events.t.end(),true_t[q].begin(),true_t[q].end());
+            events.I.insert(events.I.end(),true_I[q].begin(),true_I[q].end());
+            events.SI.insert(events.SI.end(),true_SI[q].begin(),true_SI[q].end());
+            vector < float >().swap(true_t[q]);
+            vector < uint32_t >().swap(true_I[q]);
+            vector < uint32_t >().swap(true_SI[q]);
+        }
+    }
+
+    // Merge the statistics of the threads:
+    ThreadStatistics &total = statistics[0];
+    for(size_t thread = 1; thread < n_threads; ++thread)
+    {
+        total.I.merge(statistics[thread].I);
+        total.SI.merge(statistics[thread].SI);
+        total.R.merge(statistics[thread].R);
+        for(size_t k = 0; k < total.final_I.size(); ++k)
+            total.final_I[k] += statistics[thread].final_I[k];
+        for(size_t k = 0; k < total.final_R.size(); ++k)
+            total.final_R[k] += statistics[thread].final_R[k];
+        total.stopped += statistics[thread].stopped;
+    }
+    result.number_stopped = total.stopped;
+    result.final_I_histogram.swap(total.final_I);
+    result.final_R_histogram.swap(total.final_R);
+
+    auto frame_statistics = [&](const FrameMoments &moments, const FrameQuantileSketch &sketch)
+    {
+        FrameStatistics frame;
+        frame.mean = moments.mean();
+        frame.variance = moments.variance();
+        if (with_quantiles)
+            frame.quantiles = sketch.quantiles(parameters.quantiles);
+        return frame;
+    };
+    result.I_statistics = frame_statistics(total.I, I_sketch);
+    result.SI_statistics = frame_statistics(total.SI, SI_sketch);
+    if (immunity)
+        result.R_statistics = frame_statistics(total.R, R_sketch);
+
+    return result;
+}
+
+//======================================================================
+// Parameter sweep
+//======================================================================
+// Runs parameters.number_of_simulations realizations at each of P points
+// of a parameter grid, engine_for(p) returning the engine of point p and
+// initial_infected_for(p) its initial number of infected (both are called
+// from several threads at once). All P*number_of_simulations
+// realizations go through one parallel_for, in order of the points. The
+// threads take them in chunks that shrink towards the end, so they stay
+// busy until the end even if the realizations at some points (e.g. below
+// the epidemic threshold) are much shorter than at others. Realization q of every point draws from
+// realization_generator(seed, q), i.e. from the same stream as in a
+// separate run_ensemble with the same seed.
+//
+// Only the summaries of SweepPoint are computed; frames and events are
+// not recorded. The rates of the points are left for the caller to fill
+// in.
+template < typename MAKE_ENGINE, typename INITIAL_INFECTED >
+vector < SweepPoint > run_sweep(size_t P,
+                                MAKE_ENGINE engine_for,
+                                INITIAL_INFECTED initial_infected_for,
+                                SimulationParameters parameters,
+                                const atomic < bool > *cancel = nullptr
+                               )
+{
+    typedef decltype(engine_for(0)) ENGINE;
+    const bool immunity = ENGINE::COMPARTMENT_MODEL::immunity;
+    size_t Q = parameters.number_of_simulations;
+    vector < SweepPoint > points(P);
+    if (P == 0)
+        return points;
+
+    const ENGINE engine = engine_for(0);
+    for(size_t p = 0; p < P; ++p)
+    {
+        parameters.initial_number_of_infected = initial_infected_for(p);
+        check_parameters(engine.get_network(), parameters);
+    }
+    // a single frame at the end, it is not used
+    parameters.output_time_resolution = max(parameters.T_simulation, (size_t) 1);
+    parameters.record_events = false;
+    if (parameters.seed==0)
+        parameters.seed = time(nullptr);
+
+    // Per point: (final I, final R, peak I) of all realizations
+    vector < FrameMoments > moments(P);
+    for(auto &point_moments: moments)
+        point_moments.reset(3);
+    vector < size_t > stopped(P,0);
+    vector < double > simulation_time(P,0.);
+    mutex points_mutex;
+
+    // Per thread: the point it is working on and the sums of its
+    // realizations there, added to the point when the thread moves on
+    struct ThreadSweep {
+        size_t point;
+        SimulationParameters parameters; // with the initial number of infected of the point
+        FrameMoments moments;
+        size_t stopped;
+        double simulation_time;
+        size_t frame[3]; // I, SI and R of the single frame
+    };
+    size_t n_threads = number_of_threads(parameters.n_threads, P*Q);
+    vector < ENGINE > engines(n_threads, engine);
+    vector < ThreadSweep > threads(n_threads);
+    for(auto &thread_sweep: threads)
+    {
+        thread_sweep.point = P;
+        thread_sweep.parameters = parameters;
+        thread_sweep.moments.reset(3);
+    }
+    auto flush = [&](ThreadSweep &mine)
+    {
+        if (mine.point == P)
+            return;
+        lock_guard < mutex > lock(points_mutex);
+        moments[mine.point].merge(mine.moments);
+        stopped[mine.point] += mine.stopped;
+        simulation_time[mine.point] += mine.simulation_time;
+    };
+
+    parallel_for(P*Q, n_threads, [&](size_t k, size_t thread)
+    {
+        size_t p = k / Q;
+        size_t q = k % Q;
+        ThreadSweep &mine = threads[thread];
+        if (mine.point != p)
+        {
+            flush(mine);
+            mine.point = p;
+            mine.moments.reset(3);
+            mine.stopped = 0;
+            mine.simulation_time = 0.;
+            engines[thread] = engine_for(p);
+            mine.parameters.initial_number_of_infected = initial_infected_for(p);
+            if (parameters.verbose)
+                cout << "point " << p << "/" << P << endl;
+        }
+
+        ENGINE &e = engines[thread];
+        ENG generator = realization_generator(parameters.seed, q);
+        auto start = chrono::steady_clock::now();
+        e.simulate(mine.parameters, generator, mine.frame, mine.frame+1, immunity ? mine.frame+2 : nullptr, cancel);
+        mine.simulation_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        size_t values[3] = { e.infected(), e.recovered(), e.peak_infected() };
+        mine.moments.add(values);
+        mine.stopped += e.stopped();
+    });
+    for(auto &thread_sweep: threads)
+        flush(thread_sweep);
+
+    for(size_t p = 0; p < P; ++p)
+    {
+        vector < double > mean = moments[p].mean();
+        vector < double > variance = moments[p].variance();
+        SweepPoint &point = points[p];
+        point.infection_rate_per_dt = 0.;
+        point.recovery_rate_per_dt = 0.;
+        point.initial_number_of_infected = initial_infected_for(p);
+        point.number_of_simulations = moments[p].count();
+        point.number_stopped = stopped[p];
+        point.mean_final_I = mean[0];
+        point.variance_final_I = variance[0];
+        point.mean_final_R = mean[1];
+        point.variance_final_R = variance[1];
+        point.mean_peak_I = mean[2];
+        point.variance_peak_I = variance[2];
+        point.simulation_time = simulation_time[p];
+    }
+
+    return points;
+}
+
+// Sweep of the homogeneous Poissonian MODEL over the points
+// (infection_rates[p], recovery_rates[p], initial_numbers_of_infected[p]).
+// A list of length one is used for all points.
+template < typename MODEL >
+vector < SweepPoint > Poisson_sweep(const TemporalNetwork &network,
+                                    const vector < double > &infection_rates,
+                                    const vector < double > &recovery_rates,
+                                    const vector < size_t > &initial_numbers_of_infected,
+                                    const SimulationParameters &parameters,
+                                    const atomic < bool > *cancel
+                                   )
+{
+    size_t P = max(max(infection_rates.size(), recovery_rates.size()), initial_numbers_of_infected.size());
+    if (infection_rates.empty() || recovery_rates.empty() || initial_numbers_of_infected.empty())
+        P = 0;
+    else if ((infection_rates.size() != P && infection_rates.size() != 1) ||
+             (recovery_rates.size() != P && recovery_rates.size() != 1) ||
+             (initial_numbers_of_infected.size() != P && initial_numbers_of_infected.size() != 1))
+        throw invalid_argument("infection_rates_per_dt, recovery_rates_per_dt and initial_numbers_of_infected have to be of the same length (or of length 1)");
+    auto infection_rate = [&](size_t p) { return infection_rates[infection_rates.size() == 1 ? 0 : p]; };
+    auto recovery_rate = [&](size_t p) { return recovery_rates[recovery_rates.size() == 1 ? 0 : p]; };
+    auto initial_infected = [&](size_t p) { return initial_numbers_of_infected[initial_numbers_of_infected.size() == 1 ? 0 : p]; };
+
+    vector < SweepPoint > points = run_sweep(P, [&](size_t p)
+    {
+        return TemporalGillespie < MODEL >(network, infection_rate(p), ExponentialRecovery(recovery_rate(p)));
+    }, initial_infected, parameters, cancel);
+
+    for(size_t p = 0; p < P; ++p)
+    {
+        points[p].infection_rate_per_dt = infection_rate(p);
+        points[p].recovery_rate_per_dt = recovery_rate(p);
+    }
+    return points;
+}
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "TemporalNetwork.h"
+#include <chrono>
+#include <limits>
+#include <cstring>
+
+using namespace std;
+
+TemporalNetwork::TemporalNetwork(size_t N, const CONTACTS_LIST &contactListList)
+    : N(N), max_slice_size(0)
+{
+    size_t number_of_contacts = 0;
+    for(auto const &contactList: contactListList)
+        number_of_contacts += contactList.size();
+
+    CONTACTS contacts;
+    vector < size_t > slice_offsets;
+    contacts.reserve(number_of_contacts);
+    slice_offsets.reserve(contactListList.size()+1);
+    slice_offsets.push_back(0);
+    for(auto const &contactList: contactListList)
+    {
+        for(auto const &contact: contactList)
+        {
+            if (contact.first >= N || contact.second >= N)
+                throw out_of_range("Contact (" + to_string(contact.first) + "," + to_string(contact.second)
+                                   + ") involves a node >= N = " + to_string(N));
+            contacts.push_back(contact);
+        }
+        slice_offsets.push_back(contacts.size());
+    }
+
+    set_contacts(move(contacts), move(slice_offsets));
+}
+
+TemporalNetwork TemporalNetwork::from_arrays(size_t N, const Arrays &a, bool check_contents)
+{
+    if (a.slice_offsets.empty() || a.slice_offsets[0] != 0 || a.slice_offsets.back() != a.contacts.size())
+        throw invalid_argument("slice_offsets has to start with 0 and end with the number of contacts");
+    size_t number_of_slices = a.slice_offsets.size()-1;
+    if (a.slice_node_offsets.size() != number_of_slices+1 || a.slice_node_offsets[0] != 0 || a.slice_node_offsets.back() != a.slice_nodes.size())
+        throw invalid_argument("slice_node_offsets has to have number_of_slices+1 entries from 0 to the number of slice nodes");
+    if (a.incidence_offsets.size() != a.slice_nodes.size() + number_of_slices || a.incidence.size() != 2*a.contacts.size())
+        throw invalid_argument("The incidence arrays do not match the contacts");
+
+    // all offsets stay within their arrays if they do not decrease
+    for(size_t s = 0; s < number_of_slices; ++s)
+    {
+        if (a.slice_offsets[s+1] < a.slice_offsets[s])
+            throw invalid_argument("slice_offsets decrease at slice " + to_string(s));
+        if (a.slice_node_offsets[s+1] < a.slice_node_offsets[s])
+            throw invalid_argument("slice_node_offsets decrease at slice " + to_string(s));
+    }
+    for(size_t s = 0; s < number_of_slices; ++s)
+    {
+        size_t nodes = a.slice_node_offsets[s+1]-a.slice_node_offsets[s];
+        const COUNTER *offsets = a.incidence_offsets.data() + a.slice_node_offsets[s] + s;
+        if (offsets[0] != 0 || offsets[nodes] != 2*(a.slice_offsets[s+1]-a.slice_offsets[s]))
+            throw invalid_argument("The incidence offsets of slice " + to_string(s) + " do not match its contacts");
+        for(size_t k = 0; k < nodes; ++k)
+            if (offsets[k+1] < offsets[k])
+                throw invalid_argument("The incidence offsets of slice " + to_string(s) + " decrease");
+    }
+
+    if (check_contents)
+    {
+        // ends of every contact of the slice found in the incidence so far
+        vector < unsigned char > listed;
+        for(size_t s = 0; s < number_of_slices; ++s)
+        {
+            const CONTACT *contacts = a.contacts.data() + a.slice_offsets[s];
+            size_t size = a.slice_offsets[s+1]-a.slice_offsets[s];
+            for(size_t e = 0; e < size; ++e)
+                if (contacts[e].first >= N || contacts[e].second >= N)
+                    throw invalid_argument("Contact (" + to_string(contacts[e].first) + "," + to_string(contacts[e].second)
+                                           + ") in slice " + to_string(s) + " involves a node >= N = " + to_string(N));
+
+            const NODE *nodes = a.slice_nodes.data() + a.slice_node_offsets[s];
+            const COUNTER *offsets = a.incidence_offsets.data() + a.slice_node_offsets[s] + s;
+            const COUNTER *incidence = a.incidence.data() + 2*a.slice_offsets[s];
+            listed.assign(size,0);
+            for(size_t k = 0; k < a.slice_node_offsets[s+1]-a.slice_node_offsets[s]; ++k)
+            {
+                if (nodes[k] >= N || (k > 0 && nodes[k] <= nodes[k-1]))
+                    throw invalid_argument("The nodes of slice " + to_string(s) + " are not sorted nodes < N");
+                // there are 2*size entries, so every end is listed once
+                for(size_t m = offsets[k]; m < offsets[k+1]; ++m)
+                {
+                    COUNTER e = incidence[m];
+                    if (e < size && contacts[e].first == nodes[k] && !(listed[e] & 1))
+                        listed[e] |= 1;
+                    else if (e < size && contacts[e].second == nodes[k] && !(listed[e] & 2))
+                        listed[e] |= 2;
+                    else
+                        throw invalid_argument("The incidence of slice " + to_string(s) + " does not match its contacts");
+                }
+            }
+        }
+    }
+
+    TemporalNetwork network;
+    network.N = N;
+    network.storage = a;
+    for(size_t s = 0; s < number_of_slices; ++s)
+        network.max_slice_size = max(network.max_slice_size, a.slice_offsets[s+1]-a.slice_offsets[s]);
+
+    return network;
+}
+
+void TemporalNetwork::set_contacts(CONTACTS &&contacts, vector < size_t > &&slice_offsets, size_t n_threads)
+{
+    max_slice_size = 0;
+    for(size_t s = 0; s+1 < slice_offsets.size(); ++s)
+        max_slice_size = max(max_slice_size, slice_offsets[s+1]-slice_offsets[s]);
+
+    storage.contacts = move(contacts);
+    storage.slice_offsets = move(slice_offsets);
+    build_incidence(n_threads);
+}
+
+void TemporalNetwork::check_node(long long n) const
+{
+    if (n < 0 || (size_t) n >= N)
+        throw out_of_range("Node " + to_string(n) + " is out of range for a network of N = " + to_string(N) + " nodes");
+}
+
+void TemporalNetwork::build_incidence(size_t n_threads)
+{
+    const CONTACT * contacts = storage.contacts.data();
+    const size_t * slice_offsets = storage.slice_offsets.data();
+    size_t number_of_contacts = storage.contacts.size();
+    size_t number_of_slices = storage.slice_offsets.size()-1;
+    vector < COUNTER > incidence(2*number_of_contacts);
+
+    // The slices are split into blocks of about the same number of
+    // contacts. Every block indexes its slices into its own lists, which
+    // are concatenated afterwards.
+    size_t number_of_blocks = number_of_threads(n_threads, number_of_slices);
+    vector < size_t > block_slices(number_of_blocks+1,number_of_slices);
+    for(size_t k = 0; k < number_of_blocks; ++k)
+        block_slices[k] = lower_bound(slice_offsets,slice_offsets+number_of_slices,number_of_contacts*k/number_of_blocks) - slice_offsets;
+    block_slices[0] = 0;
+
+    vector < NODES > block_nodes(number_of_blocks); // per slice, the sorted nodes that have contacts
+    vector < vector < size_t > > block_node_counts(number_of_blocks); // per slice, the number of these nodes
+    vector < vector < COUNTER > > block_offsets(number_of_blocks); // per slice, nodes+1 offsets into the slice's incidence
+
+    parallel_for(number_of_blocks, number_of_blocks, [&](size_t k, size_t)
+    {
+        NODES &nodes_list = block_nodes[k];
+        vector < COUNTER > &offsets_list = block_offsets[k];
+        nodes_list.reserve(2*(slice_offsets[block_slices[k+1]]-slice_offsets[block_slices[k]]));
+        // index of a node among the nodes of the current slice
+        vector < COUNTER > position(N);
+        vector < COUNTER > fill;
+
+        for(size_t s = block_slices[k]; s < block_slices[k+1]; ++s)
+        {
+            const CONTACT * first = contacts + slice_offsets[s];
+            size_t size = slice_offsets[s+1] - slice_offsets[s];
+
+            // sorted list of nodes with contacts in this slice
+            size_t nodes_start = nodes_list.size();
+            for(size_t e = 0; e < size; ++e)
+            {
+                nodes_list.push_back(first[e].first);
+                nodes_list.push_back(first[e].second);
+            }
+            NODES::iterator nodes_begin = nodes_list.begin() + nodes_start;
+            sort(nodes_begin,nodes_list.end());
+            nodes_list.erase(unique(nodes_begin,nodes_list.end()),nodes_list.end());
+            block_node_counts[k].push_back(nodes_list.size()-nodes_start);
+
+            const NODE * nodes = nodes_list.data() + nodes_start;
+            const NODE * nodes_end = nodes_list.data() + nodes_list.size();
+            size_t number_of_nodes = nodes_end - nodes;
+
+            for(size_t m = 0; m < number_of_nodes; ++m)
+                position[nodes[m]] = m;
+
+            // count contacts per node, then scatter the contact indices
+            size_t offsets_start = offsets_list.size();
+            offsets_list.resize(offsets_start+number_of_nodes+1,0);
+            COUNTER * offsets = offsets_list.data() + offsets_start;
+            for(size_t e = 0; e < size; ++e)
+            {
+                offsets[position[first[e].first]+1]++;
+                offsets[position[first[e].second]+1]++;
+            }
+            partial_sum(offsets,offsets+number_of_nodes+1,offsets);
+
+            fill.assign(offsets,offsets+number_of_nodes);
+            COUNTER * slice_incidence = incidence.data() + 2*slice_offsets[s];
+            for(size_t e = 0; e < size; ++e)
+            {
+                slice_incidence[fill[position[first[e].first]]++] = e;
+                slice_incidence[fill[position[first[e].second]]++] = e;
+            }
+        }
+    });
+
+    NODES slice_nodes;
+    vector < size_t > slice_node_offsets(1,0);
+    vector < COUNTER > incidence_offsets;
+    if (number_of_blocks == 1)
+    {
+        slice_nodes.swap(block_nodes[0]);
+        incidence_offsets.swap(block_offsets[0]);
+    }
+    for(size_t k = 0; k < number_of_blocks; ++k)
+    {
+        if (number_of_blocks > 1)
+        {
+            slice_nodes.insert(slice_nodes.end(),block_nodes[k].begin(),block_nodes[k].end());
+            incidence_offsets.insert(incidence_offsets.end(),block_offsets[k].begin(),block_offsets[k].end());
+        }
+        for(auto const &count: block_node_counts[k])
+            slice_node_offsets.push_back(slice_node_offsets.back()+count);
+    }
+
+    storage.slice_nodes = move(slice_nodes);
+    storage.slice_node_offsets = move(slice_node_offsets);
+    storage.incidence_offsets = move(incidence_offsets);
+    storage.incidence = move(incidence);
+}
+
+// Only an identical slice can be followed by a run, so slices are
+// compared with the next one from the end.
+const vector < COUNTER > & TemporalNetwork::slice_repeats() const
+{
+    call_once(runs->found, [this]()
+    {
+        vector < COUNTER > &repeats = runs->repeats;
+        size_t T = number_of_slices();
+        repeats.assign(T,1);
+        for(size_t s = T; s-- > 1; )
+        {
+            Slice previous = slice(s-1), current = slice(s);
+            if (previous.size() == current.size() && (current.empty() || memcmp(previous.begin(), current.begin(), current.size()*sizeof(CONTACT)) == 0))
+                repeats[s-1] = repeats[s] + 1;
+        }
+    });
+    return runs->repeats;
+}
+
+// The nodes of every slice are listed already, so their slices are
+// counted and scattered in order of s.
+const TemporalNetwork::NodeSlices & TemporalNetwork::node_slices() const
+{
+    call_once(contact_slices->listed, [this]()
+    {
+        const Arrays &a = storage;
+        size_t T = number_of_slices();
+        vector < size_t > &offsets = contact_slices->offsets;
+        vector < COUNTER > &slices = contact_slices->slices;
+        offsets.assign(N+1,0);
+        for(size_t k = 0; k < a.slice_node_offsets[T]; ++k)
+            offsets[a.slice_nodes[k]+1]++;
+        partial_sum(offsets.begin(),offsets.end(),offsets.begin());
+
+        vector < size_t > fill(offsets.begin(),offsets.end()-1);
+        slices.resize(offsets[N]);
+        for(size_t s = 0; s < T; ++s)
+            for(size_t k = a.slice_node_offsets[s]; k < a.slice_node_offsets[s+1]; ++k)
+                slices[fill[a.slice_nodes[k]]++] = (COUNTER) s;
+    });
+    return *contact_slices;
+}
+
+size_t TemporalNetwork::next_contact(NODE n, size_t s) const
+{
+    const NodeSlices &listed = node_slices();
+    const COUNTER *first = listed.slices.data() + listed.offsets[n];
+    const COUNTER *last = listed.slices.data() + listed.offsets[n+1];
+    const COUNTER *next = lower_bound(first, last, s);
+    return next == last ? number_of_slices() : *next;
+}
+
+TemporalNetwork::Slice TemporalNetwork::slice(size_t s) const
+{
+    const Arrays &a = storage;
+    Slice slice;
+    slice.contacts_begin = a.contacts.data() + a.slice_offsets[s];
+    slice.contacts_end = a.contacts.data() + a.slice_offsets[s+1];
+    slice.nodes_first = a.slice_nodes.data() + a.slice_node_offsets[s];
+    slice.nodes_last = a.slice_nodes.data() + a.slice_node_offsets[s+1];
+    slice.offsets = a.incidence_offsets.data() + a.slice_node_offsets[s] + s;
+    slice.incidence = a.incidence.data() + 2*a.slice_offsets[s];
+    return slice;
+}
+
+//======================================================================
+// SI contacts of a slice from its infected nodes
+//======================================================================
+size_t find_si_contacts(const TemporalNetwork::Slice &slice, const IndexedSet &infected, const STATE *state, COUNTER *si)
+{
+    // a contact of an infected node is SI if the other node is susceptible,
+    // so every SI contact is visited once
+    size_t count = 0;
+    for(size_t n: infected)
+    {
+        auto incident = slice.incident((NODE) n);
+        for(const COUNTER *e = incident.first; e != incident.second; ++e)
+            if (state[slice[*e].first] + state[slice[*e].second] == INFECTED)
+                si[count++] = *e;
+    }
+    sort(si, si+count);
+    return count;
+}
+
+// Cost of finding the SI contacts from the infected nodes, per infected
+// node and contact of an infected node, relative to the cost per contact
+// of scanning the whole slice. Measured on a random slice that fits into
+// the cache, with 1/32 of the nodes infected.
+static double relative_cost_from_infected()
+{
+    static const double ratio = []()
+    {
+        const size_t N = 1 << 14, number_of_contacts = 1 << 15, repetitions = 5;
+        ENG generator(1);
+        uniform_int_distribution < NODE > node(0, N-1);
+        CONTACTS_LIST contacts(1);
+        while (contacts[0].size() < number_of_contacts)
+        {
+            NODE i = node(generator), j = node(generator);
+            if (i != j)
+                contacts[0].push_back(make_pair(i,j));
+        }
+        TemporalNetwork network(N, contacts);
+        TemporalNetwork::Slice slice = network.slice(0);
+
+        STATES state(N+STATE_PADDING,SUSCEPTIBLE);
+        IndexedSet infected;
+        infected.reset(N);
+        while (infected.size() < N/32)
+        {
+            NODE n = node(generator);
+            infected.insert(n);
+            state[n] = INFECTED;
+        }
+        size_t visits = 0;
+        for(size_t n: infected)
+        {
+            auto incident = slice.incident((NODE) n);
+            visits += 1 + (incident.second - incident.first);
+        }
+
+        vector < COUNTER > si(number_of_contacts);
+        double all_time = numeric_limits < double >::infinity();
+        double infected_time = numeric_limits < double >::infinity();
+        for(size_t r = 0; r < repetitions; ++r)
+        {
+            auto start = chrono::steady_clock::now();
+            find_si_contacts(slice.begin(), slice.size(), state.data(), si.data());
+            auto middle = chrono::steady_clock::now();
+            find_si_contacts(slice, infected, state.data(), si.data());
+            auto end = chrono::steady_clock::now();
+            all_time = min(all_time, chrono::duration<double>(middle - start).count());
+            infected_time = min(infected_time, chrono::duration<double>(end - middle).count());
+        }
+        return (infected_time / visits) / (all_time / number_of_contacts);
+    }();
+    return ratio;
+}
+
+bool scan_from_infected(size_t number_of_infected, size_t number_of_contacts, size_t N)
+{
+    // every contact has two nodes, 2E/N per node on average
+    double visits = number_of_infected * (1. + 2.*number_of_contacts/max(N, (size_t) 1));
+    return visits * relative_cost_from_infected() < number_of_contacts;
+}
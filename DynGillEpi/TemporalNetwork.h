@@ -0,0 +1,358 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2018, Benjamin Maier
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall
+ * be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-
+ * INFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef __TEMPORAL_NETWORK_H__
+#define __TEMPORAL_NETWORK_H__
+
+#include <Utilities.h>
+#include <mutex>
+
+using namespace std;
+
+//======================================================================
+// Immutable array sharing its storage between copies. The storage is
+// either a vector owned by the array or memory kept alive by another
+// object (e.g. a memory mapped file).
+//======================================================================
+template < typename T >
+class SharedArray {
+    public:
+        SharedArray() : first(nullptr), length(0) {}
+
+        SharedArray(vector < T > &&values)
+        {
+            auto values_storage = make_shared < vector < T > >(move(values));
+            first = values_storage->data();
+            length = values_storage->size();
+            owner = values_storage;
+        }
+
+        SharedArray(const shared_ptr < const void > &owner, const T *first, size_t length)
+            : owner(owner), first(first), length(length)
+        {}
+
+        const T * data() const { return first; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        const T & operator[](size_t k) const { return first[k]; }
+        const T & back() const { return first[length-1]; }
+        const T * begin() const { return first; }
+        const T * end() const { return first+length; }
+        // the object keeping the storage alive
+        const shared_ptr < const void > & storage() const { return owner; }
+
+    private:
+        shared_ptr < const void > owner;
+        const T * first;
+        size_t length;
+};
+
+//======================================================================
+// Immutable temporal network in compressed (CSR) form
+//======================================================================
+// All contacts are stored in one flat array, slice s holding
+// contacts[slice_offsets[s]:slice_offsets[s+1]]. For every slice, the
+// nodes with at least one contact are stored sorted together with the
+// indices (local to the slice) of the contacts they take part in, such
+// that the engines can update only the contacts of a node that changed
+// its state. Copies share these arrays.
+class TemporalNetwork {
+    public:
+        //------------------------------------------------------------------
+        // The arrays a network consists of
+        //------------------------------------------------------------------
+        struct Arrays {
+            SharedArray < CONTACT > contacts; // all contacts, ordered by slice
+            SharedArray < size_t > slice_offsets; // number_of_slices+1 offsets into contacts
+            SharedArray < NODE > slice_nodes; // per slice, the sorted nodes that have contacts
+            SharedArray < size_t > slice_node_offsets; // number_of_slices+1 offsets into slice_nodes
+            SharedArray < COUNTER > incidence_offsets; // per slice, slice_nodes+1 offsets into the slice's incidence
+            SharedArray < COUNTER > incidence; // per slice, contact indices grouped by node (2 per contact)
+        };
+
+        //------------------------------------------------------------------
+        // View on a single time slice
+        //------------------------------------------------------------------
+        class Slice {
+            public:
+                typedef const CONTACT * const_iterator;
+
+                const_iterator begin() const { return contacts_begin; }
+                const_iterator end() const { return contacts_end; }
+                size_t size() const { return contacts_end - contacts_begin; }
+                bool empty() const { return contacts_begin == contacts_end; }
+                const CONTACT & operator[](size_t e) const { return contacts_begin[e]; }
+
+                // nodes with at least one contact in this slice (sorted)
+                const NODE * nodes_begin() const { return nodes_first; }
+                const NODE * nodes_end() const { return nodes_last; }
+
+                // Indices of the contacts node n takes part in. The range
+                // is empty if n has no contact in this slice.
+                pair < const COUNTER *, const COUNTER * > incident(NODE n) const
+                {
+                    const NODE * node = lower_bound(nodes_first,nodes_last,n);
+                    if (node == nodes_last || *node != n)
+                        return make_pair(incidence,incidence);
+                    size_t k = node - nodes_first;
+                    return make_pair(incidence+offsets[k],incidence+offsets[k+1]);
+                }
+
+            private:
+                friend class TemporalNetwork;
+                const CONTACT * contacts_begin;
+                const CONTACT * contacts_end;
+                const NODE * nodes_first;
+                const NODE * nodes_last;
+                const COUNTER * offsets;
+                const COUNTER * incidence;
+        };
+
+        //------------------------------------------------------------------
+        // Iterator over slices, used like CONTACTS_LIST::iterator
+        //------------------------------------------------------------------
+        class const_iterator {
+            public:
+                const_iterator(const TemporalNetwork *network, size_t s) : network(network), s(s) {}
+                Slice operator*() const { return network->slice(s); }
+                const_iterator & operator++() { ++s; return *this; }
+                const_iterator operator++(int) { const_iterator it = *this; ++s; return it; }
+                const_iterator operator+(size_t ds) const { return const_iterator(network,s+ds); }
+                ptrdiff_t operator-(const const_iterator &other) const { return (ptrdiff_t) s - (ptrdiff_t) other.s; }
+                bool operator==(const const_iterator &other) const { return s == other.s; }
+                bool operator!=(const const_iterator &other) const { return s != other.s; }
+                size_t index() const { return s; }
+
+            private:
+                const TemporalNetwork *network;
+                size_t s;
+        };
+
+        //------------------------------------------------------------------
+        // Access to the slices as the engines use it: one Reader per
+        // engine, asked for the slices in order (starting over at the end
+        // of the data). Networks that are streamed from disk (see
+        // StreamedNetwork) have a Reader with the same interface.
+        //------------------------------------------------------------------
+        class Reader {
+            public:
+                Reader(const TemporalNetwork *network = nullptr) : network(network) {}
+                Slice slice(size_t s) { return network->slice(s); }
+                // see TemporalNetwork::repeats, for the slice s last handed out
+                size_t repeats(size_t s) { return network->repeats(s); }
+                // see TemporalNetwork::next_contact
+                size_t next_contact(NODE n, size_t s) { return network->next_contact(n,s); }
+
+            private:
+                const TemporalNetwork *network;
+        };
+
+        TemporalNetwork() : N(0), max_slice_size(0)
+        {
+            storage.slice_offsets = vector < size_t >(1,0);
+            storage.slice_node_offsets = vector < size_t >(1,0);
+        }
+
+        // Build from a list of contact lists, one per time slice.
+        // Throws out_of_range if a contact involves a node >= N.
+        TemporalNetwork(size_t N, const CONTACTS_LIST &contactListList);
+
+        // Build from a contiguous (number_of_contacts x 2) array of node
+        // pairs ordered by slice, where slice s holds the contacts
+        // edges[slice_offsets[s]:slice_offsets[s+1]].
+        template < typename NODE_INT, typename OFFSET_INT >
+        static TemporalNetwork from_edge_arrays(size_t N,
+                                                const NODE_INT *edges,
+                                                size_t number_of_contacts,
+                                                const OFFSET_INT *slice_offsets,
+                                                size_t number_of_slices
+                                               );
+
+        // Build from three contiguous arrays (t, i, j) with one contact
+        // per entry and t given in time steps. The contacts do not need to
+        // be ordered by t. If number_of_slices is 0, it is max(t)+1.
+        // The slices are indexed on n_threads threads (0 means one per
+        // hardware thread).
+        template < typename INT >
+        static TemporalNetwork from_tij_arrays(size_t N,
+                                               const INT *t,
+                                               const INT *i,
+                                               const INT *j,
+                                               size_t number_of_contacts,
+                                               size_t number_of_slices = 0,
+                                               size_t n_threads = 1
+                                              );
+
+        // Network on arrays as returned by arrays() of another network,
+        // which are shared, not copied. Throws invalid_argument unless the
+        // sizes match and the offsets do not decrease, O(number of slices
+        // + slice nodes). With check_contents, also unless every node is
+        // < N, the nodes of every slice are sorted and the incidence only
+        // holds contacts of its slice, O(number of contacts); else the
+        // contacts of a memory mapped file are not read before they are
+        // needed.
+        static TemporalNetwork from_arrays(size_t N, const Arrays &arrays, bool check_contents = false);
+
+        size_t number_of_nodes() const { return N; }
+        size_t number_of_slices() const { return storage.slice_offsets.size()-1; }
+        size_t number_of_contacts() const { return storage.contacts.size(); }
+        size_t max_contacts_per_slice() const { return max_slice_size; }
+        // index of the first contact of slice s among all contacts
+        size_t first_contact(size_t s) const { return storage.slice_offsets[s]; }
+        // Number of slices s,s+1,... that hold the same contacts in the
+        // same order as slice s, at least 1 and not beyond the last slice.
+        // The runs of identical slices are found on first use.
+        size_t repeats(size_t s) const { return slice_repeats()[s]; }
+        // First slice from s on in which node n has a contact, or
+        // number_of_slices() if there is none. The slices of every node
+        // are listed on first use, O(log(number of them)) per call.
+        size_t next_contact(NODE n, size_t s) const;
+        const Arrays & arrays() const { return storage; }
+
+        Slice slice(size_t s) const;
+        const_iterator begin() const { return const_iterator(this,0); }
+        const_iterator end() const { return const_iterator(this,number_of_slices()); }
+
+    private:
+        void check_node(long long n) const;
+        // takes over the contacts (ordered by slice) and builds the incidence
+        void set_contacts(CONTACTS &&contacts, vector < size_t > &&slice_offsets, size_t n_threads = 1);
+        void build_incidence(size_t n_threads);
+
+        // lengths of the runs of identical slices, shared by copies
+        struct SliceRuns {
+            once_flag found;
+            vector < COUNTER > repeats;
+        };
+        const vector < COUNTER > & slice_repeats() const;
+
+        // slices in which every node has a contact, shared by copies
+        struct NodeSlices {
+            once_flag listed;
+            vector < size_t > offsets; // node n has a contact in slices[offsets[n]:offsets[n+1]]
+            vector < COUNTER > slices;
+        };
+        const NodeSlices & node_slices() const;
+
+        size_t N;
+        size_t max_slice_size;
+        Arrays storage;
+        shared_ptr < SliceRuns > runs = make_shared < SliceRuns >();
+        shared_ptr < NodeSlices > contact_slices = make_shared < NodeSlices >();
+};
+
+//======================================================================
+// SI contacts of a slice from its infected nodes
+//======================================================================
+// Writes the indices of the SI contacts of slice to si, in increasing
+// order as find_si_contacts(slice.begin(), slice.size(), ...) does, and
+// returns their number. Only the contacts of the infected nodes are
+// visited, O(log n) to find them plus their number.
+size_t find_si_contacts(const TemporalNetwork::Slice &slice, const IndexedSet &infected, const STATE *state, COUNTER *si);
+
+// Whether the SI contacts of a slice of number_of_contacts contacts among
+// N nodes are found faster from number_of_infected infected nodes than by
+// scanning all contacts. An infected node is taken to have the average
+// number of contacts, the cost of both ways is measured once on a random
+// slice.
+bool scan_from_infected(size_t number_of_infected, size_t number_of_contacts, size_t N);
+
+//======================================================================
+// Construction from raw arrays
+//======================================================================
+template < typename NODE_INT, typename OFFSET_INT >
+TemporalNetwork TemporalNetwork::from_edge_arrays(size_t N,
+                                                  const NODE_INT *edges,
+                                                  size_t number_of_contacts,
+                                                  const OFFSET_INT *slice_offsets,
+                                                  size_t number_of_slices
+                                                 )
+{
+    TemporalNetwork network;
+    network.N = N;
+
+    if (slice_offsets[0] != 0 || (size_t) slice_offsets[number_of_slices] != number_of_contacts)
+        throw invalid_argument("slice_offsets has to start with 0 and end with the number of contacts");
+
+    vector < size_t > offsets(number_of_slices+1);
+    for(size_t s = 0; s <= number_of_slices; ++s)
+    {
+        if (s > 0 && slice_offsets[s] < slice_offsets[s-1])
+            throw invalid_argument("slice_offsets has to be non-decreasing");
+        offsets[s] = slice_offsets[s];
+    }
+
+    CONTACTS contacts(number_of_contacts);
+    for(size_t e = 0; e < number_of_contacts; ++e)
+    {
+        network.check_node(edges[2*e]);
+        network.check_node(edges[2*e+1]);
+        contacts[e] = make_pair((NODE) edges[2*e], (NODE) edges[2*e+1]);
+    }
+
+    network.set_contacts(move(contacts), move(offsets));
+
+    return network;
+}
+
+template < typename INT >
+TemporalNetwork TemporalNetwork::from_tij_arrays(size_t N,
+                                                 const INT *t,
+                                                 const INT *i,
+                                                 const INT *j,
+                                                 size_t number_of_contacts,
+                                                 size_t number_of_slices,
+                                                 size_t n_threads
+                                                )
+{
+    TemporalNetwork network;
+    network.N = N;
+
+    for(size_t e = 0; e < number_of_contacts; ++e)
+    {
+        if (t[e] < 0)
+            throw invalid_argument("t has to be non-negative");
+        network.check_node(i[e]);
+        network.check_node(j[e]);
+        number_of_slices = max(number_of_slices, (size_t) t[e] + 1);
+    }
+
+    // counting sort of the contacts by t (stable, so the order of contacts
+    // within a slice is the order they were given in)
+    vector < size_t > offsets(number_of_slices+1,0);
+    for(size_t e = 0; e < number_of_contacts; ++e)
+        offsets[t[e]+1]++;
+    partial_sum(offsets.begin(),offsets.end(),offsets.begin());
+
+    vector < size_t > fill(offsets.begin(),offsets.end()-1);
+    CONTACTS contacts(number_of_contacts);
+    for(size_t e = 0; e < number_of_contacts; ++e)
+        contacts[fill[t[e]]++] = make_pair((NODE) i[e], (NODE) j[e]);
+
+    network.set_contacts(move(contacts), move(offsets), n_threads);
+
+    return network;
+}
+
+#endif
@@ -24,6 +24,19 @@
  */
 
 #include "Utilities.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <exception>
+
+// CPU features are detected at run time, every kernel is compiled for its
+// instruction set with the target attribute
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SI_SCAN_X86
+#include <immintrin.h>
+#endif
 
 
 using namespace std;
@@ -48,3 +61,276 @@ vector<size_t>::iterator choose_random_unique(
 }
 
 
+
+ENG realization_generator(size_t seed, size_t q)
+{
+    uint64_t s = seed;
+    uint64_t r = q;
+    seed_seq seq { (uint32_t) s, (uint32_t) (s >> 32), (uint32_t) r, (uint32_t) (r >> 32) };
+    return ENG(seq);
+}
+
+size_t number_of_threads(size_t n_threads, size_t n)
+{
+    if (n_threads == 0)
+        n_threads = max(1u, thread::hardware_concurrency());
+    return max((size_t) 1, min(n_threads, n));
+}
+
+ThreadUtilization parallel_for(size_t n, size_t n_threads, const function < void(size_t, size_t) > &f)
+{
+    n_threads = number_of_threads(n_threads, n);
+
+    ThreadUtilization threads;
+    threads.tasks.assign(n_threads,0);
+    threads.busy_time.assign(n_threads,0.);
+    auto start = chrono::steady_clock::now();
+
+    if (n_threads == 1)
+    {
+        for(size_t k = 0; k < n; ++k)
+            f(k, 0);
+        threads.tasks[0] = n;
+        threads.wall_time = threads.busy_time[0] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return threads;
+    }
+
+    // chunks of a 1/CHUNKS_PER_THREAD share per thread of the remaining tasks
+    const size_t CHUNKS_PER_THREAD = 4;
+    atomic < size_t > next(0);
+    exception_ptr error;
+    mutex error_mutex;
+
+    auto work = [&](size_t thread_index)
+    {
+        // counted locally, the threads' entries share cache lines
+        size_t tasks = 0;
+        double busy_time = 0.;
+        size_t first = next.load(memory_order_relaxed);
+        while (first < n)
+        {
+            size_t last = first + max((size_t) 1, (n-first) / (CHUNKS_PER_THREAD*n_threads));
+            if (!next.compare_exchange_weak(first, last))
+                continue; // first holds the current value now
+
+            auto chunk_start = chrono::steady_clock::now();
+            for(size_t k = first; k < last; ++k)
+            {
+                try
+                {
+                    f(k, thread_index);
+                    tasks++;
+                }
+                catch (...)
+                {
+                    lock_guard < mutex > lock(error_mutex);
+                    if (!error)
+                        error = current_exception();
+                    next = n; // let the other threads run out
+                    break;
+                }
+            }
+            busy_time += chrono::duration<double>(chrono::steady_clock::now() - chunk_start).count();
+            first = next.load(memory_order_relaxed);
+        }
+        threads.tasks[thread_index] = tasks;
+        threads.busy_time[thread_index] = busy_time;
+    };
+
+    vector < thread > pool;
+    for(size_t thread_index = 1; thread_index < n_threads; ++thread_index)
+        pool.emplace_back(work, thread_index);
+    work(0);
+    for(auto &th: pool)
+        th.join();
+    threads.wall_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (error)
+        rethrow_exception(error);
+    return threads;
+}
+
+//======================================================================
+// SI contacts of a slice
+//======================================================================
+// A contact (i,j) is SI iff state[i]+state[j] == INFECTED. Every index is
+// written and only kept if the contact is SI, without a branch to
+// mispredict (si has room for n indices). Scans contacts first,...,n-1
+// after count SI contacts were found.
+static inline size_t si_scan_range(const CONTACT *contacts, size_t first, size_t n, const STATE *state, COUNTER *si, size_t count)
+{
+    for(size_t e = first; e < n; ++e)
+    {
+        si[count] = e;
+        count += state[contacts[e].first] + state[contacts[e].second] == INFECTED;
+    }
+    return count;
+}
+
+static size_t si_scan_scalar(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si)
+{
+    return si_scan_range(contacts, 0, n, state, si, 0);
+}
+
+#ifdef SI_SCAN_X86
+// For every 8 bit mask, the positions of its set bits packed into 4 bits
+// each, lowest first
+static const vector < uint32_t > SET_BIT_POSITIONS = []()
+{
+    vector < uint32_t > positions(256,0);
+    for(unsigned mask = 0; mask < 256; ++mask)
+        for(unsigned k = 0, count = 0; k < 8; ++k)
+            if ((mask >> k) & 1)
+                positions[mask] |= k << (4*count++);
+    return positions;
+}();
+
+// The nodes of 8 contacts are loaded as 16 consecutive ints, their states
+// gathered as 4 bytes each (hence STATE_PADDING) and masked to the first.
+// The indices of the SI contacts are shuffled to the front of a vector
+// (SET_BIT_POSITIONS) and all 8 stored, the next ones overwrite the rest.
+__attribute__((target("avx2")))
+static size_t si_scan_avx2(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si)
+{
+    const int *nodes = reinterpret_cast < const int * >(contacts);
+    const int *states = reinterpret_cast < const int * >(state);
+    const __m256i all = _mm256_set1_epi32(-1);
+    const __m256i first_byte = _mm256_set1_epi32(0xFF);
+    const __m256i nibble = _mm256_set1_epi32(0xF);
+    const __m256i nibble_shifts = _mm256_setr_epi32(0,4,8,12,16,20,24,28);
+    const __m256i infected = _mm256_set1_epi32(INFECTED);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_setr_epi32(0,1,2,3,4,5,6,7);
+
+    size_t count = 0;
+    size_t e = 0;
+    for(; e + 8 <= n; e += 8)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast < const __m256i * >(nodes + 2*e)); // contacts e,...,e+3
+        __m256i b = _mm256_loadu_si256(reinterpret_cast < const __m256i * >(nodes + 2*e + 8)); // contacts e+4,...,e+7
+        a = _mm256_and_si256(_mm256_mask_i32gather_epi32(all, states, a, all, 1), first_byte);
+        b = _mm256_and_si256(_mm256_mask_i32gather_epi32(all, states, b, all, 1), first_byte);
+        // hadd sums the pairs per 128 bit lane, as contacts e,e+1,e+4,e+5,e+2,e+3,e+6,e+7
+        __m256i sums = _mm256_permute4x64_epi64(_mm256_hadd_epi32(a, b), 0xD8);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sums, infected)));
+        __m256i positions = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(SET_BIT_POSITIONS[mask]), nibble_shifts), nibble);
+        _mm256_storeu_si256(reinterpret_cast < __m256i * >(si + count), _mm256_permutevar8x32_epi32(index, positions));
+        count += __builtin_popcount(mask);
+        index = _mm256_add_epi32(index, step);
+    }
+    return si_scan_range(contacts, e, n, state, si, count);
+}
+
+// As the AVX2 kernel for 16 contacts, the indices of the SI contacts are
+// written with a compress store. (The masked intrinsics with a zero source
+// keep GCC from warning about the undefined one of the plain ones.)
+__attribute__((target("avx512f")))
+static size_t si_scan_avx512(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si)
+{
+    const int *nodes = reinterpret_cast < const int * >(contacts);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i first_byte = _mm512_set1_epi32(0xFF);
+    const __m512i low_half = _mm512_set1_epi64(0xFFFFFFFF);
+    const __m512i infected = _mm512_set1_epi64(INFECTED);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i index = _mm512_setr_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+
+    size_t count = 0;
+    size_t e = 0;
+    for(; e + 16 <= n; e += 16)
+    {
+        __m512i a = _mm512_loadu_si512(nodes + 2*e); // contacts e,...,e+7
+        __m512i b = _mm512_loadu_si512(nodes + 2*e + 16); // contacts e+8,...,e+15
+        a = _mm512_and_si512(_mm512_mask_i32gather_epi32(zero, 0xFFFF, a, state, 1), first_byte);
+        b = _mm512_and_si512(_mm512_mask_i32gather_epi32(zero, 0xFFFF, b, state, 1), first_byte);
+        // the sum of a contact's states in the low half of its 64 bits
+        a = _mm512_and_si512(_mm512_add_epi64(a, _mm512_maskz_srli_epi64(0xFF, a, 32)), low_half);
+        b = _mm512_and_si512(_mm512_add_epi64(b, _mm512_maskz_srli_epi64(0xFF, b, 32)), low_half);
+        __mmask16 mask = _mm512_cmpeq_epi64_mask(a, infected) | (_mm512_cmpeq_epi64_mask(b, infected) << 8);
+        _mm512_mask_compressstoreu_epi32(si + count, mask, index);
+        count += __builtin_popcount(mask);
+        index = _mm512_add_epi32(index, step);
+    }
+    return si_scan_range(contacts, e, n, state, si, count);
+}
+#endif
+
+typedef pair < string, SI_SCAN > NAMED_SI_SCAN;
+
+// The kernels the CPU supports
+static vector < NAMED_SI_SCAN > supported_si_scans()
+{
+    vector < NAMED_SI_SCAN > kernels { { "scalar", si_scan_scalar } };
+#ifdef SI_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back({ "avx2", si_scan_avx2 });
+    if (__builtin_cpu_supports("avx512f"))
+        kernels.push_back({ "avx512", si_scan_avx512 });
+#endif
+    return kernels;
+}
+
+// Gathers are slow on some CPUs (e.g. with the microcode fix for
+// gather data sampling), slower than the scalar loop even. The kernels
+// are therefore timed once, on a slice of random contacts among nodes
+// that fit into the cache, and the fastest is used. All kernels give the
+// same result, the choice only affects the run time.
+static const NAMED_SI_SCAN & fastest_si_scan()
+{
+    static const NAMED_SI_SCAN fastest = []()
+    {
+        const size_t N = 1 << 12, number_of_contacts = 1 << 14, repetitions = 5;
+        ENG generator(1);
+        uniform_int_distribution < NODE > node(0, N-1);
+        CONTACTS contacts(number_of_contacts);
+        for(auto &contact: contacts)
+            contact = make_pair(node(generator), node(generator));
+        STATES state(N+STATE_PADDING,SUSCEPTIBLE);
+        for(size_t n = 0; n < N; n += 10)
+            state[n] = INFECTED;
+        vector < COUNTER > si(number_of_contacts);
+
+        NAMED_SI_SCAN fastest;
+        double fastest_time = numeric_limits < double >::infinity();
+        for(const auto &kernel: supported_si_scans())
+        {
+            for(size_t r = 0; r < repetitions; ++r)
+            {
+                auto start = chrono::steady_clock::now();
+                kernel.second(contacts.data(), number_of_contacts, state.data(), si.data());
+                double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (time < fastest_time)
+                {
+                    fastest_time = time;
+                    fastest = kernel;
+                }
+            }
+        }
+        return fastest;
+    }();
+    return fastest;
+}
+
+SI_SCAN si_scan_kernel(const string &name)
+{
+    if (name.empty())
+        return fastest_si_scan().second;
+    for(const auto &kernel: supported_si_scans())
+        if (kernel.first == name)
+            return kernel.second;
+    if (name == "scalar" || name == "avx2" || name == "avx512")
+        throw invalid_argument("The SI scan kernel '" + name + "' is not supported on this machine");
+    throw invalid_argument("Unknown SI scan kernel '" + name + "', use 'scalar', 'avx2' or 'avx512'");
+}
+
+string si_scan_kernel_name()
+{
+    return fastest_si_scan().first;
+}
+
+size_t find_si_contacts(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si)
+{
+    static const SI_SCAN kernel = si_scan_kernel("");
+    return kernel(contacts, n, state, si);
+}
@@ -38,17 +38,131 @@
 #include <ctime>
 #include <cstdlib>
 #include <tuple>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <string>
 
 using namespace std;
 
+//======================================================================
+// Contiguous row-major 2D buffer. The storage is reference counted such
+// that it can be handed out (e.g. to NumPy) without copying and outlive
+// the object it belongs to.
+//======================================================================
+template < typename T >
+class Array2D {
+    public:
+        Array2D(size_t rows = 0, size_t cols = 0)
+            : n_rows(rows), n_cols(cols), storage(make_shared< vector < T > >(rows*cols))
+        {}
+
+        size_t rows() const { return n_rows; }
+        size_t cols() const { return n_cols; }
+        T * data() { return storage->data(); }
+        const T * data() const { return storage->data(); }
+        T * row(size_t r) { return storage->data() + r*n_cols; }
+        const T * row(size_t r) const { return storage->data() + r*n_cols; }
+        T & operator()(size_t r, size_t c) { return (*storage)[r*n_cols+c]; }
+        const T & operator()(size_t r, size_t c) const { return (*storage)[r*n_cols+c]; }
+        const shared_ptr < vector < T > > & buffer() const { return storage; }
+
+    private:
+        size_t n_rows;
+        size_t n_cols;
+        shared_ptr < vector < T > > storage;
+};
+
+// Statistics of an observable over all realizations, per recorded frame
+struct FrameStatistics {
+    vector < double > mean;
+    vector < double > variance; // unbiased sample variance
+    Array2D < double > quantiles; // shape (number of quantiles asked for, number of frames)
+};
+
+// (t, I, SI) at the start of every slice and after every event, in
+// compact columns. Realization q holds the entries
+// offsets[q] <= m < offsets[q+1]. Times are single precision, i.e.
+// resolved to about 1e-7 of the time since the start.
+struct EventRecord {
+    vector < float > t; // in time steps
+    vector < uint32_t > I; // number of infected
+    vector < uint32_t > SI; // number of SI contacts
+    vector < size_t > offsets; // number_of_simulations+1 offsets (empty if nothing was recorded)
+};
+
+// How parallel_for kept its threads busy
+struct ThreadUtilization {
+    vector < size_t > tasks; // number of tasks per thread
+    vector < double > busy_time; // seconds spent in the tasks, per thread
+    double wall_time = 0.; // of the whole loop in seconds
+
+    // fraction of the wall time thread was busy
+    double utilization(size_t thread) const { return wall_time > 0 ? busy_time[thread] / wall_time : 0.; }
+};
+
+// e.g. "threads: 8, busy: 97.3% (min 95.1%)"
+inline ostream & operator<<(ostream &out, const ThreadUtilization &threads)
+{
+    double total = 0., least = threads.tasks.empty() ? 0. : 1.;
+    for(size_t thread = 0; thread < threads.tasks.size(); ++thread)
+    {
+        total += threads.utilization(thread);
+        least = min(least, threads.utilization(thread));
+    }
+    double mean = threads.tasks.empty() ? 0. : total / threads.tasks.size();
+    return out << "threads: " << threads.tasks.size() << ", busy: " << round(1000*mean)/10
+               << "% (min " << round(1000*least)/10 << "%)";
+}
+
+// The per-realization arrays (I, SI, R and hist) are empty if the
+// realizations were not stored, events only if they were recorded. The
+// statistics are always filled in.
 struct SI_result {
-    vector < size_t > true_I;
-    vector < size_t > true_SI;
-    vector < double > true_t;
+    EventRecord events;
 
-    vector < vector < size_t > > I;
-    vector < vector < size_t > > SI;
+    Array2D < size_t > I; // shape (number_of_simulations, T_simulation/output_time_resolution)
+    Array2D < size_t > SI; // same shape as I
     vector < size_t > hist;
+
+    FrameStatistics I_statistics;
+    FrameStatistics SI_statistics;
+    vector < size_t > final_size_histogram; // number of realizations ending with I = k, k = 0,...,N
+
+    ThreadUtilization threads; // of the realizations
+};
+
+struct SIR_result {
+    EventRecord events;
+
+    Array2D < size_t > I; // shape (number_of_simulations, T_simulation/output_time_resolution)
+    Array2D < size_t > SI; // same shape as I
+    Array2D < size_t > R; // same shape as I
+    vector < size_t > hist; // number of recovered at the end of each realization
+
+    FrameStatistics I_statistics;
+    FrameStatistics SI_statistics;
+    FrameStatistics R_statistics;
+    vector < size_t > final_size_histogram; // number of realizations ending with R = k, k = 0,...,N
+
+    ThreadUtilization threads; // of the realizations
+};
+
+// Summary of the realizations at one point of a parameter sweep
+struct SweepPoint {
+    double infection_rate_per_dt;
+    double recovery_rate_per_dt;
+    size_t initial_number_of_infected;
+    size_t number_of_simulations;
+    size_t number_stopped; // realizations in which the infection died out
+    double mean_final_I; // infected at the end of a realization
+    double variance_final_I;
+    double mean_final_R; // recovered at the end of a realization (0 for SIS)
+    double variance_final_R;
+    double mean_peak_I; // largest number of infected during a realization
+    double variance_peak_I;
+    double simulation_time; // wall time of the realizations in seconds, summed over the threads
 };
 
 //======================================================================
@@ -59,15 +173,123 @@ typedef unsigned int COUNTER;
 typedef unsigned int NODE;
 typedef vector<NODE> NODES; // list of nodes
 typedef vector<bool> BOOLS;
+typedef unsigned char STATE; // compartment of a node
+typedef vector<STATE> STATES; // compartments of all nodes
 typedef pair<NODE,NODE> CONTACT; // contact (i,j)
 typedef vector<CONTACT> CONTACTS; // contacts in a single time-frame
 typedef vector<CONTACTS> CONTACTS_LIST; // list of contact lists
 // Random number generators:
-typedef default_random_engine ENG; // use Mersenne Twister 19937 as PRNG engine
+typedef mt19937_64 ENG; // use Mersenne Twister 19937 as PRNG engine
 typedef uniform_int_distribution<size_t> DIST_INT; // define uniform distribution of integers
 typedef uniform_real_distribution<double> DIST_REAL; // define uniform distribution of reals on [0,1)
 typedef exponential_distribution<double> DIST_EXP; // define exponential distribution
+// Compartments (a contact (i,j) is an SI contact iff state[i]+state[j] == INFECTED):
+enum : STATE { SUSCEPTIBLE = 0, INFECTED = 1, RECOVERED = 2 };
+
+
+//======================================================================
+// Set of integers 0 <= e < capacity with O(1) insert, erase and
+// uniform sampling (elements are kept in a dense array, removal swaps
+// the last element into the freed slot)
+//======================================================================
+class IndexedSet {
+    public:
+        void reset(size_t capacity)
+        {
+            elements.clear();
+            position.assign(capacity,(size_t) NOT_IN_SET);
+        }
+
+        void clear()
+        {
+            for(auto const &e: elements)
+                position[e] = NOT_IN_SET;
+            elements.clear();
+        }
+
+        bool contains(size_t e) const { return position[e] != NOT_IN_SET; }
+        size_t size() const { return elements.size(); }
+        size_t capacity() const { return position.size(); }
+        size_t operator[](size_t m) const { return elements[m]; }
+        vector<size_t>::const_iterator begin() const { return elements.begin(); }
+        vector<size_t>::const_iterator end() const { return elements.end(); }
+
+        void insert(size_t e)
+        {
+            if (contains(e))
+                return;
+            position[e] = elements.size();
+            elements.push_back(e);
+        }
+
+        void erase(size_t e)
+        {
+            if (!contains(e))
+                return;
+            size_t m = position[e];
+            elements[m] = elements.back();
+            position[elements[m]] = m;
+            elements.pop_back();
+            position[e] = NOT_IN_SET;
+        }
+
+    private:
+        static const size_t NOT_IN_SET = (size_t) -1;
+        vector < size_t > elements;
+        vector < size_t > position;
+};
+
+// Thrown by a simulation that stopped because it was asked to cancel
+class SimulationCancelled : public runtime_error {
+    public:
+        SimulationCancelled() : runtime_error("The simulation was cancelled") {}
+};
+
+// Throws SimulationCancelled if cancel is set (cancel may be null).
+inline void check_cancelled(const atomic < bool > *cancel)
+{
+    if (cancel && cancel->load(memory_order_relaxed))
+        throw SimulationCancelled();
+}
+
+// Independent generator for realization q of a simulation with the given
+// seed. The stream only depends on (seed, q), such that an ensemble gives
+// the same results independent of how it is split over threads.
+ENG realization_generator(size_t seed, size_t q);
+
+// Calls f(k, thread) for k = 0,...,n-1 on n_threads threads (0 means one
+// per hardware thread). The k are handed out in consecutive chunks to the
+// next free thread, each chunk a share of what is left, such that the
+// chunks are large at first (few atomic operations on the shared counter)
+// and single tasks at the end (no thread waits long for another). thread
+// = 0,...,n_threads-1 identifies the calling thread (e.g. to use
+// per-thread buffers). An exception thrown by f is rethrown in the
+// calling thread after all threads have finished.
+ThreadUtilization parallel_for(size_t n, size_t n_threads, const function < void(size_t, size_t) > &f);
+
+// Number of threads parallel_for will use for n tasks.
+size_t number_of_threads(size_t n_threads, size_t n);
+
+// Scanning a slice for SI contacts:
+// find_si_contacts reads the states of four consecutive nodes at once, a
+// STATES array has to hold STATE_PADDING entries beyond the last node.
+const size_t STATE_PADDING = 3;
+
+// Writes the indices e of the SI contacts among contacts[0,...,n-1] to si
+// (room for n), in increasing order, and returns their number. The states
+// of the nodes are gathered 16 (AVX-512) or 8 (AVX2) contacts at a time if
+// the CPU supports it and that is faster, see si_scan_kernel.
+size_t find_si_contacts(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si);
+
+// The implementations of find_si_contacts, "scalar", "avx2" or "avx512",
+// "" is the one of those the CPU supports that ran fastest when first
+// asked for. Throws invalid_argument if the CPU or the compiler does not
+// support the kernel.
+typedef size_t (*SI_SCAN)(const CONTACT *contacts, size_t n, const STATE *state, COUNTER *si);
+SI_SCAN si_scan_kernel(const string &name);
 
+// Name of the kernel find_si_contacts uses.
+string si_scan_kernel_name();
 
 vector<size_t>::iterator choose_random_unique(
         vector<size_t>::iterator begin, 
@@ -0,0 +1,66 @@
+/* Converts a temporal network given on the form (t i j), with one triple
+per line, to the binary network format of NetworkFiles.h. The engines
+and the Python module map a binary file into memory instead of parsing
+it, such that loading takes about as long as opening the file.
+
+Should be compiled with g++ together with Utilities.cpp,
+TemporalNetwork.cpp and NetworkFiles.cpp using the options -O2 -std=c++14, i.e., as
+g++ convert-tij.cpp Utilities.cpp TemporalNetwork.cpp NetworkFiles.cpp -o convert-tij -O2 -std=c++14 -pthread -I.
+
+It is called from the shell as:
+./convert-tij <data> dt <output>
+where:
+<data> - path of text file containing contact data (temporal network);
+dt - time-resolution of recorded contact data (time-step length);
+<output> - path of the binary network file to write.
+
+The binary file keeps dt and the labels of the nodes in <data>; node n
+of the network is the n-th smallest label.*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <stdlib.h>
+#include <iostream>
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <NetworkFiles.h>
+
+//======================================================================
+// Main:
+//======================================================================
+int main(int argc, char *argv[])
+{
+    // Check if correct number of parameters was passed to program:
+    if(argc<3){ std::cout << "Error! Data file not defined.\n"; return 0; }
+    else
+    {
+        if(argc<4){ std::cout << "Error! Output file not defined.\n"; return 0; }
+    }
+    char *datafile=argv[1]; //dataset file name
+    COUNTER dt=atoi(argv[2]); //dataset time resolution (integer)
+    char *outputfile=argv[3]; //binary network file name
+
+    try
+    {
+        // Parse the text file:
+        std::cout << "Filename: " << datafile << std::endl;
+        NetworkFile file=load_tij(datafile,dt);
+        std::cout << file.network.number_of_nodes() << " nodes, " << file.network.number_of_contacts() << " contacts, "
+                  << file.network.number_of_slices() << " time-frames. Construction time: " << file.load_time
+                  << " s (" << file.megabytes_per_second() << " MB/s)" << std::endl;
+
+        // Write the binary file and map it again to check it:
+        std::clock_t clockStart = std::clock();
+        save_network(outputfile,file);
+        NetworkFile binary=load_network(outputfile);
+        std::cout << "Wrote " << outputfile << " (" << binary.bytes/1e6 << " MB) in " << ( std::clock() - clockStart ) / (double) CLOCKS_PER_SEC
+                  << " s, mapping it takes " << binary.load_time << " s" << std::endl;
+    }
+    catch(std::exception &error)
+    {
+        std::cout << "ERROR! " << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+/* Compares the samplers of Samplers.h that the heterogeneous engines can
+use, on the operations of a simulation: changing the weight of a key
+(a node recovers, a contact becomes SI) followed by drawing a key.
+
+The weights are drawn log-uniformly from [1, dynamic range]. The
+composition-rejection sampler searches through about log2(dynamic range)
+groups per draw but updates in O(1), the sum tree does not depend on the
+range but walks log2(n) levels per update and draw, with a cache miss per
+level once the tree is large. The cumulative sampler is only run for small
+sets, its updates are O(n). At last, the heterogeneous SIR engine is run on a random
+temporal network with each sampler.
+
+Compile and run from this directory as
+g++ sampler_benchmark.cpp ../DynGillEpi/Utilities.cpp ../DynGillEpi/TemporalNetwork.cpp -o sampler_benchmark -O2 -std=c++14 -pthread -I../DynGillEpi
+./sampler_benchmark*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+
+using namespace std;
+
+//======================================================================
+// Benchmarks
+//======================================================================
+// nanoseconds per update and draw, for n keys with weights in [1, range]
+template < typename SAMPLER >
+double time_per_operation(size_t n, double range, size_t operations)
+{
+    ENG generator(12345);
+    DIST_REAL rand(0.0,1.0);
+
+    // draw keys and weights beforehand, only the sampler is timed
+    const size_t table_size = 1 << 16;
+    vector < size_t > keys(table_size);
+    vector < double > weights(table_size);
+    for(size_t m = 0; m < table_size; ++m)
+    {
+        keys[m] = (size_t) (n * rand(generator));
+        weights[m] = pow(range, rand(generator));
+    }
+
+    SAMPLER sampler;
+    sampler.reset(n);
+    for(size_t key = 0; key < n; ++key)
+        sampler.insert(key, weights[key % table_size]);
+
+    size_t checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for(size_t op = 0; op < operations; ++op)
+    {
+        size_t m = op % table_size;
+        if (op % 2 == 0)
+            sampler.erase(keys[m]);
+        sampler.insert(keys[m], weights[(m+1) % table_size]);
+        checksum += sampler.sample(generator);
+    }
+    chrono::duration < double, nano > elapsed = chrono::steady_clock::now() - start;
+
+    // keep the compiler from dropping the draws
+    if (checksum == (size_t) -1)
+        cout << checksum;
+
+    return elapsed.count() / operations;
+}
+
+// wall time of an ensemble of the heterogeneous SIR process in seconds
+template < typename SAMPLER >
+double time_ensemble(const TemporalNetwork &network, double sigma)
+{
+    size_t N = network.number_of_nodes();
+    ENG generator(42);
+    lognormal_distribution < double > factor(0.0, sigma);
+    vector < double > susceptibilities(N), infectivities(N), recoverabilities(N);
+    for(size_t n = 0; n < N; ++n)
+    {
+        susceptibilities[n] = factor(generator);
+        infectivities[n] = factor(generator);
+        recoverabilities[n] = factor(generator);
+    }
+
+    typedef HeterogeneousRates < SAMPLER > RATES;
+    TemporalGillespie < SIR, RATES > engine(network, 0.5, ExponentialRecovery(0.02), RATES(susceptibilities,infectivities,recoverabilities));
+    SimulationParameters parameters;
+    parameters.T_simulation = 200;
+    parameters.number_of_simulations = 4;
+    parameters.initial_number_of_infected = 50;
+    parameters.seed = 5;
+    return run_ensemble(engine, parameters).simulation_time;
+}
+
+//======================================================================
+// Main:
+//======================================================================
+int main()
+{
+    const size_t operations = 2000000;
+
+    cout << "ns per update and draw" << endl;
+    cout << setw(10) << "n" << setw(10) << "range"
+         << setw(12) << "sum_tree" << setw(24) << "composition_rejection" << setw(12) << "cumulative" << endl;
+    for(size_t n: { 100, 10000, 1000000 })
+        for(double range: { 1., 1e2, 1e6, 1e12 })
+        {
+            cout << setw(10) << n << setw(10) << range << fixed << setprecision(1)
+                 << setw(12) << time_per_operation < SumTreeSampler > (n, range, operations)
+                 << setw(24) << time_per_operation < CompositionRejectionSampler > (n, range, operations);
+            if (n <= 10000)
+                cout << setw(12) << time_per_operation < CumulativeSampler > (n, range, operations/10);
+            cout << defaultfloat << endl;
+        }
+
+    // random temporal network of 10^5 nodes, 10^5 contacts per slice
+    size_t N = 100000, T = 50;
+    ENG generator(1);
+    uniform_int_distribution < NODE > node(0, N-1);
+    CONTACTS_LIST contacts(T);
+    for(size_t t = 0; t < T; ++t)
+        for(size_t k = 0; k < 100000; ++k)
+        {
+            NODE i = node(generator), j = node(generator);
+            if (i != j)
+                contacts[t].push_back(make_pair(i,j));
+        }
+    TemporalNetwork network(N, contacts);
+
+    cout << endl << "heterogeneous SIR, N=" << N << ", log-normal factors, seconds" << endl;
+    cout << setw(10) << "sigma" << setw(12) << "sum_tree" << setw(24) << "composition_rejection" << setw(12) << "cumulative" << endl;
+    for(double sigma: { 0.5, 1.5 })
+    {
+        cout << setw(10) << sigma << fixed << setprecision(2)
+             << setw(12) << time_ensemble < SumTreeSampler > (network, sigma)
+             << setw(24) << time_ensemble < CompositionRejectionSampler > (network, sigma)
+             << setw(12) << time_ensemble < CumulativeSampler > (network, sigma)
+             << defaultfloat << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+/* Compares the kernels of find_si_contacts (Utilities.h), which pick the
+SI contacts out of a slice at the start of every time step: the scalar
+loop, and the AVX2 and AVX-512 kernels, which gather the states of 8 or
+16 contacts at once. Kernels the CPU does not support are skipped.
+
+The slices hold 10^5 to 10^6 random contacts between N nodes, a fraction
+of which is infected. Once the states do not fit into the cache anymore,
+every contact costs two cache misses whatever the kernel, such that the
+gathers gain most for small and medium N. At last, the homogeneous SIS
+engine is timed on a network with large slices.
+
+Compile and run from this directory as
+g++ si_scan_benchmark.cpp ../DynGillEpi/Utilities.cpp ../DynGillEpi/TemporalNetwork.cpp -o si_scan_benchmark -O2 -std=c++14 -pthread -I../DynGillEpi
+./si_scan_benchmark*/
+//======================================================================
+// Libraries
+//======================================================================
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <Utilities.h>
+#include <TemporalNetwork.h>
+#include <TemporalGillespie.h>
+
+using namespace std;
+
+//======================================================================
+// Benchmarks
+//======================================================================
+// random contacts between N nodes
+CONTACTS random_contacts(size_t N, size_t number_of_contacts, ENG &generator)
+{
+    uniform_int_distribution < NODE > node(0, N-1);
+    CONTACTS contacts;
+    while (contacts.size() < number_of_contacts)
+    {
+        NODE i = node(generator), j = node(generator);
+        if (i != j)
+            contacts.push_back(make_pair(i,j));
+    }
+    return contacts;
+}
+
+// states of N nodes, each infected with probability infected, otherwise
+// susceptible or recovered alike
+STATES random_states(size_t N, double infected, ENG &generator)
+{
+    DIST_REAL rand(0.0,1.0);
+    STATES state(N+STATE_PADDING,SUSCEPTIBLE);
+    for(size_t n = 0; n < N; ++n)
+    {
+        double r = rand(generator);
+        state[n] = r < infected ? INFECTED : r < (1.+infected)/2. ? SUSCEPTIBLE : RECOVERED;
+    }
+    return state;
+}
+
+// nanoseconds per contact, checks the result against the scalar kernel
+double time_per_contact(const string &kernel, const CONTACTS &contacts, const STATES &state, const vector < COUNTER > &expected)
+{
+    SI_SCAN scan = si_scan_kernel(kernel);
+    vector < COUNTER > si(contacts.size());
+    size_t repetitions = max((size_t) 1, (size_t) 20000000 / contacts.size());
+
+    size_t count = 0;
+    auto start = chrono::steady_clock::now();
+    for(size_t r = 0; r < repetitions; ++r)
+        count = scan(contacts.data(), contacts.size(), state.data(), si.data());
+    chrono::duration < double, nano > elapsed = chrono::steady_clock::now() - start;
+
+    si.resize(count);
+    if (si != expected)
+        throw logic_error("The " + kernel + " kernel finds other SI contacts than the scalar one");
+
+    return elapsed.count() / (repetitions * contacts.size());
+}
+
+// wall time of an ensemble of the homogeneous SIS process in seconds
+double time_ensemble(const TemporalNetwork &network)
+{
+    TemporalGillespie < SIS > engine(network, 0.01, ExponentialRecovery(1.0));
+    SimulationParameters parameters;
+    parameters.T_simulation = 100;
+    parameters.number_of_simulations = 4;
+    parameters.initial_number_of_infected = network.number_of_nodes() / 10;
+    parameters.seed = 5;
+    parameters.lockstep = false;
+    return run_ensemble(engine, parameters).simulation_time;
+}
+
+//======================================================================
+// Main:
+//======================================================================
+int main()
+{
+    vector < string > kernels;
+    for(string kernel: { "scalar", "avx2", "avx512" })
+    {
+        try
+        {
+            si_scan_kernel(kernel);
+            kernels.push_back(kernel);
+        }
+        catch (const invalid_argument &)
+        {
+            cout << kernel << " is not supported on this machine" << endl;
+        }
+    }
+    cout << "find_si_contacts uses " << si_scan_kernel_name() << endl << endl;
+
+    ENG generator(1);
+
+    cout << "ns per contact" << endl;
+    cout << setw(10) << "N" << setw(10) << "contacts" << setw(10) << "infected";
+    for(const auto &kernel: kernels)
+        cout << setw(10) << kernel;
+    cout << setw(10) << "speedup" << endl;
+    for(size_t N: { 10000, 100000, 1000000, 10000000 })
+        for(size_t number_of_contacts: { 100000, 1000000 })
+            for(double infected: { 0.01, 0.1, 0.5 })
+            {
+                CONTACTS contacts = random_contacts(N, number_of_contacts, generator);
+                STATES state = random_states(N, infected, generator);
+                vector < COUNTER > expected(contacts.size());
+                expected.resize(si_scan_kernel("scalar")(contacts.data(), contacts.size(), state.data(), expected.data()));
+
+                cout << setw(10) << N << setw(10) << number_of_contacts << setw(10) << infected << fixed << setprecision(2);
+                vector < double > times;
+                for(const auto &kernel: kernels)
+                {
+                    times.push_back(time_per_contact(kernel, contacts, state, expected));
+                    cout << setw(10) << times.back();
+                }
+                cout << setw(10) << times.front() / *min_element(times.begin(), times.end()) << defaultfloat << endl;
+            }
+
+    // random temporal network of 10^5 nodes, 10^6 contacts per slice
+    size_t N = 100000, T = 20;
+    CONTACTS_LIST contacts_list(T);
+    for(auto &contacts: contacts_list)
+        contacts = random_contacts(N, 1000000, generator);
+    TemporalNetwork network(N, contacts_list);
+
+    cout << endl << "homogeneous SIS, N=" << N << ", 10^6 contacts per slice, "
+         << si_scan_kernel_name() << ": " << time_ensemble(network) << " seconds" << endl;
+
+    return 0;
+}
@@ -23,7 +23,14 @@ ext_modules = [
         'DynGillEpi',
         [ 
             'DynGillEpi/Utilities.cpp', 
+            'DynGillEpi/TemporalNetwork.cpp', 
+            'DynGillEpi/NetworkFiles.cpp', 
             'DynGillEpi/SIS_Poisson_homogeneous.cpp', 
+            'DynGillEpi/SIS_Poisson_heterogeneous.cpp', 
+            'DynGillEpi/SIR_Poisson_homogeneous.cpp', 
+            'DynGillEpi/SIR_Poisson_heterogeneous.cpp', 
+            'DynGillEpi/SIR_Poisson_homogeneous_contactRemoval.cpp', 
+            'DynGillEpi/SIR_nonMarkovian.cpp', 
             'DynGillEpi/DynGillEpi.cpp', 
         ],
         include_dirs=[
@@ -31,6 +38,8 @@ ext_modules = [
             get_pybind_include(user=True),
             "./DynGillEpi/"
         ],
+        # shm_open is in librt before glibc 2.34
+        libraries=['rt'] if sys.platform.startswith('linux') else [],
         language='c++',
     ),
 ]
@@ -50,15 +59,13 @@ def has_flag(compiler, flagname):
     return True
 
 def cpp_flag(compiler):
-    """Return the -std=c++[11/14] compiler flag.
-    The c++14 is preferred over c++11 (when it is available).
+    """Return the -std=c++14 compiler flag.
+    The sources use generic lambdas, so C++11 is not enough.
     """
     if has_flag(compiler, '-std=c++14'):
         return '-std=c++14'
-    elif has_flag(compiler, '-std=c++11'):
-        return '-std=c++11'
     else:
-        raise RuntimeError('Unsupported compiler -- at least C++11 support is needed!')
+        raise RuntimeError('Unsupported compiler -- at least C++14 support is needed!')
 
 
 class BuildExt(build_ext):
@@ -78,8 +85,11 @@ class BuildExt(build_ext):
             opts.append(cpp_flag(self.compiler))
             if has_flag(self.compiler, '-fvisibility=hidden'):
                 opts.append('-fvisibility=hidden')
+            opts.append('-pthread')
         for ext in self.extensions:
             ext.extra_compile_args = opts
+            if ct == 'unix':
+                ext.extra_link_args = ['-pthread']
         build_ext.build_extensions(self)
 
 setup(